@@ -0,0 +1,114 @@
+#ifndef BASIC_PID_H
+#define BASIC_PID_H
+
+/*
+* Header-only PID controllers templated on the value type, so the update can
+* be inlined into the caller and run on float, double or a fixed-point type.
+* T needs copy construction from double, +, -, * and unary -.
+*
+* Both follow PID::UpdateError / PID::TotalError exactly; for T = double the
+* results are bit-identical to PID.
+*/
+
+/*
+* Gains chosen at run time.
+*/
+template <typename T>
+class BasicPID {
+public:
+  /*
+  * Errors
+  */
+  T p_error;
+  T i_error;
+  T d_error;
+
+  /*
+  * Coefficients
+  */
+  T Kp;
+  T Ki;
+  T Kd;
+
+  BasicPID() : p_error(0.0), i_error(0.0), d_error(0.0), Kp(0.0), Ki(0.0), Kd(0.0) {}
+
+  void Init(T Kp, T Ki, T Kd) {
+    this->Kp = Kp;
+    this->Ki = Ki;
+    this->Kd = Kd;
+    p_error = T(0.0);
+    i_error = T(0.0);
+    d_error = T(0.0);
+  }
+
+  void UpdateError(T cte) {
+    d_error = cte - p_error;
+    p_error = cte;
+    i_error = i_error + cte;
+  }
+
+  T TotalError() const {
+    return -Kp * p_error + -Ki * i_error + -Kd * d_error;
+  }
+};
+
+/*
+* Gains fixed at compile time by a policy with static constexpr double Kp, Ki
+* and Kd members, for example:
+*
+*   struct SteerGains {
+*     static constexpr double Kp = 0.15, Ki = 0.0, Kd = 3.31;
+*   };
+*   StaticPID<double, SteerGains> pid;
+*
+* Terms whose gain is zero are removed at compile time, including the state
+* they would need (a zero Ki skips the integral entirely).
+*/
+template <typename T, typename Gains>
+class StaticPID {
+public:
+  /*
+  * Errors
+  */
+  T p_error;
+  T i_error;
+  T d_error;
+
+  StaticPID() : p_error(0.0), i_error(0.0), d_error(0.0) {}
+
+  void Init() {
+    p_error = T(0.0);
+    i_error = T(0.0);
+    d_error = T(0.0);
+  }
+
+  void UpdateError(T cte) {
+    if (Gains::Kd != 0.0)
+      d_error = cte - p_error;
+    p_error = cte;
+    if (Gains::Ki != 0.0)
+      i_error = i_error + cte;
+  }
+
+  // Adding a -0.0 term leaves any other sum unchanged, so skipping the zero
+  // terms gives the same bits as the full expression.
+  T TotalError() const {
+    T total = Gains::Kp != 0.0 ? T(-Gains::Kp) * p_error : T(-0.0);
+    if (Gains::Ki != 0.0)
+      total = total + T(-Gains::Ki) * i_error;
+    if (Gains::Kd != 0.0)
+      total = total + T(-Gains::Kd) * d_error;
+    return total;
+  }
+};
+
+/*
+* The steering gains used by main().
+*/
+struct TunedSteerGains {
+  static constexpr double Kp = 0.15;
+  static constexpr double Ki = 0.0;
+  static constexpr double Kd = 3.31;
+};
+
+#endif /* BASIC_PID_H */
@@ -0,0 +1,128 @@
+#include "Checkpoint.h"
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+static const char kCheckpointMagic[8] = {'P', 'I', 'D', 'C', 'K', 'P', 'T', '\0'};
+static const uint32_t kCheckpointVersion = 1;
+
+namespace {
+
+struct CheckpointHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t kind;
+  uint64_t history;
+  uint64_t reserved;
+};
+
+// The fixed fields as they are laid out on disk
+struct CheckpointBody {
+  int32_t stage;
+  int32_t curr_i;
+  int32_t curr_iter;
+  int32_t sweeps;
+  int32_t evaluations;
+  int32_t done;
+  int32_t pruned;
+  int32_t reserved;
+  double p[3];
+  double dp[3];
+  double best_p[3];
+  double best_err;
+  double err;
+};
+
+}  // namespace
+
+TuneCheckpoint::TuneCheckpoint()
+    : kind(TunerKind::LIVE_TWIDDLE), stage(0), curr_i(0), curr_iter(0), sweeps(0), evaluations(0),
+      done(0), pruned(0), p{0, 0, 0}, dp{0, 0, 0}, best_p{0, 0, 0}, best_err(0.0), err(0.0) {}
+
+bool SaveCheckpoint(const std::string& path, const TuneCheckpoint& checkpoint) {
+    const std::string tmp = path + ".tmp";
+    FILE *file = fopen(tmp.c_str(), "wb");
+    if (!file)
+        return false;
+
+    CheckpointHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kCheckpointMagic, sizeof(kCheckpointMagic));
+    header.version = kCheckpointVersion;
+    header.kind = static_cast<uint32_t>(checkpoint.kind);
+    header.history = checkpoint.history.size();
+
+    CheckpointBody body;
+    std::memset(&body, 0, sizeof(body));
+    body.stage = checkpoint.stage;
+    body.curr_i = checkpoint.curr_i;
+    body.curr_iter = checkpoint.curr_iter;
+    body.sweeps = checkpoint.sweeps;
+    body.evaluations = checkpoint.evaluations;
+    body.done = checkpoint.done;
+    body.pruned = checkpoint.pruned;
+    std::memcpy(body.p, checkpoint.p, sizeof(body.p));
+    std::memcpy(body.dp, checkpoint.dp, sizeof(body.dp));
+    std::memcpy(body.best_p, checkpoint.best_p, sizeof(body.best_p));
+    body.best_err = checkpoint.best_err;
+    body.err = checkpoint.err;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(&body, sizeof(body), 1, file) == 1;
+    if (ok && !checkpoint.history.empty())
+        ok = fwrite(checkpoint.history.data(), sizeof(EvalRecord), checkpoint.history.size(), file)
+            == checkpoint.history.size();
+    // The data has to be on disk before the rename makes it visible
+    ok = fflush(file) == 0 && ok;
+    ok = fsync(fileno(file)) == 0 && ok;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool LoadCheckpoint(const std::string& path, TuneCheckpoint& checkpoint) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    CheckpointHeader header;
+    CheckpointBody body;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+        && std::memcmp(header.magic, kCheckpointMagic, sizeof(kCheckpointMagic)) == 0
+        && header.version == kCheckpointVersion
+        && fread(&body, sizeof(body), 1, file) == 1;
+    std::vector<EvalRecord> history;
+    if (ok) {
+        // Check the history length against the file before allocating it
+        const long offset = ftell(file);
+        ok = fseek(file, 0, SEEK_END) == 0
+            && static_cast<uint64_t>(ftell(file) - offset) / sizeof(EvalRecord) == header.history
+            && fseek(file, offset, SEEK_SET) == 0;
+    }
+    if (ok) {
+        history.resize(header.history);
+        ok = header.history == 0
+            || fread(history.data(), sizeof(EvalRecord), history.size(), file) == history.size();
+    }
+    fclose(file);
+    if (!ok)
+        return false;
+
+    checkpoint.kind = static_cast<TunerKind>(header.kind);
+    checkpoint.stage = body.stage;
+    checkpoint.curr_i = body.curr_i;
+    checkpoint.curr_iter = body.curr_iter;
+    checkpoint.sweeps = body.sweeps;
+    checkpoint.evaluations = body.evaluations;
+    checkpoint.done = body.done;
+    checkpoint.pruned = body.pruned;
+    std::memcpy(checkpoint.p, body.p, sizeof(body.p));
+    std::memcpy(checkpoint.dp, body.dp, sizeof(body.dp));
+    std::memcpy(checkpoint.best_p, body.best_p, sizeof(body.best_p));
+    checkpoint.best_err = body.best_err;
+    checkpoint.err = body.err;
+    checkpoint.history.swap(history);
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+* One scored gain vector.
+*/
+struct EvalRecord {
+  double p[3];
+  double err;
+};
+
+/*
+* Which tuner wrote a checkpoint.
+*/
+enum class TunerKind : uint32_t {LIVE_TWIDDLE = 1, PARALLEL_TWIDDLE = 2};
+
+/*
+* Complete state of a twiddle run, enough to continue it where it stopped.
+* The live twiddle() uses every field; ParallelTwiddle only needs p, dp,
+* best_err, sweeps, evaluations and the history.
+*/
+struct TuneCheckpoint {
+  TunerKind kind;
+  int32_t stage;          // twiddle() FSM stage
+  int32_t curr_i;         // gain being twiddled
+  int32_t curr_iter;      // frames into the current run
+  int32_t sweeps;
+  int32_t evaluations;
+  int32_t done;           // sum(dp) fell below the threshold
+  int32_t pruned;         // the current run was stopped early, err is a bound
+  double p[3];
+  double dp[3];
+  double best_p[3];
+  double best_err;
+  double err;             // |cte| summed so far in the current run
+  std::vector<EvalRecord> history;
+
+  TuneCheckpoint();
+};
+
+/*
+* Write the checkpoint to path.tmp, flush it to disk and rename it over path,
+* so path always holds either the previous or the new checkpoint in full.
+*
+* The file is a 32 byte header ("PIDCKPT", version, kind, history length), the
+* fixed fields and the history records, in host byte order.
+*/
+bool SaveCheckpoint(const std::string& path, const TuneCheckpoint& checkpoint);
+
+/*
+* Read a checkpoint written by SaveCheckpoint. Returns false if the file is
+* missing, truncated or of another version.
+*/
+bool LoadCheckpoint(const std::string& path, TuneCheckpoint& checkpoint);
+
+#endif /* CHECKPOINT_H */
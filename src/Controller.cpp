@@ -0,0 +1,69 @@
+#include "Controller.h"
+
+Controller::Controller()
+    : throttle_mean(0.4), throttle_max(0.7), throttle(0.4), steer(0.0),
+      control_every(1), frame_(0), pending_dt_(0.0) {
+    // The simulator takes steering values in [-1, 1]
+    pid.SetOutputLimits(-1.0, 1.0);
+    pid.SetAntiWindup(AntiWindup::CLAMP);
+}
+
+void Controller::Init(const double sParams[], const double tParams[],
+                      double throttle_mean, double throttle_max) {
+    pid.Init(sParams[0], sParams[1], sParams[2]);
+    throttle_pid.Init(tParams[0], tParams[1], tParams[2]);
+    this->throttle_mean = throttle_mean;
+    this->throttle_max = throttle_max;
+    Reset();
+}
+
+void Controller::Reset() {
+    pid.Reset();
+    throttle_pid.Reset();
+    throttle = throttle_mean;
+    steer = 0.0;
+    frame_ = 0;
+    pending_dt_ = 0.0;
+}
+
+void Controller::SetAntiWindup(AntiWindup mode, double tracking_gain) {
+    pid.SetAntiWindup(mode, tracking_gain);
+    throttle_pid.SetAntiWindup(mode, tracking_gain);
+}
+
+void Controller::SetTimeBase(double time_base, double d_filter_tau) {
+    pid.time_base = throttle_pid.time_base = time_base;
+    pid.d_filter_tau = throttle_pid.d_filter_tau = d_filter_tau;
+}
+
+void Controller::Step(double cte, double speed, double& steer_value, double& throttle_value) {
+    Step(cte, speed, 0.0, steer_value, throttle_value);
+}
+
+void Controller::Step(double cte, double speed, double dt, double& steer_value, double& throttle_value) {
+    // Skipped frames only add to the time step of the next update
+    pending_dt_ += dt;
+    if (control_every > 1 && frame_++ % control_every != 0) {
+        steer_value = steer;
+        throttle_value = throttle;
+        return;
+    }
+    dt = pending_dt_;
+    pending_dt_ = 0.0;
+
+    pid.ScheduleGains(speed);
+    pid.UpdateError(cte, dt);
+    steer_value = pid.Output();
+
+    // Update and get throttle value. It is contrained to be around
+    //  the value of throttle we want
+    throttle_pid.UpdateError(cte, dt);
+    throttle = throttle_mean;// - throttle_pid.TotalError();
+
+    // Don't let throttle get beyond a certain maximum
+    if (throttle >= throttle_max)
+        throttle = throttle_max;
+
+    steer = steer_value;
+    throttle_value = throttle;
+}
@@ -0,0 +1,77 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include "PID.h"
+
+/*
+* Steering and throttle logic of test(), independent of the websocket so the
+* same code drives the live simulator, trace replay and offline tuning.
+*/
+class Controller {
+public:
+  /*
+  * Controllers
+  */
+  PID pid;
+  PID throttle_pid;
+
+  /*
+  * Throttle set point and ceiling
+  */
+  double throttle_mean;
+  double throttle_max;
+
+  /*
+  * Last commanded throttle and steering
+  */
+  double throttle;
+  double steer;
+
+  /*
+  * Only recompute the commands every control_every frames and repeat the
+  * last ones in between. Needs the time-aware update to keep the gains valid.
+  */
+  int control_every;
+
+  Controller();
+
+  /*
+  * Initialize both PIDs with {Kp, Ki, Kd} for steering and throttle.
+  */
+  void Init(const double sParams[], const double tParams[],
+            double throttle_mean = 0.4, double throttle_max = 0.7);
+
+  /*
+  * Clear the PID state, e.g. after the simulator was reset.
+  */
+  void Reset();
+
+  /*
+  * Select the anti-windup mode of both PIDs. Steering defaults to CLAMP.
+  */
+  void SetAntiWindup(AntiWindup mode, double tracking_gain = 1.0);
+
+  /*
+  * Compute the steering value, saturated to [-1, 1], and the throttle for
+  * one telemetry frame.
+  */
+  void Step(double cte, double speed, double& steer_value, double& throttle_value);
+
+  /*
+  * Same, for a frame that arrived dt seconds after the previous one. Both
+  * PIDs use the time-aware update when their time_base is set, and the
+  * steering gains follow pid.schedule when one is attached.
+  */
+  void Step(double cte, double speed, double dt, double& steer_value, double& throttle_value);
+
+  /*
+  * Make both PIDs time-aware, see PID::UpdateError(cte, dt).
+  */
+  void SetTimeBase(double time_base, double d_filter_tau = 0.0);
+
+private:
+  int frame_;
+  double pending_dt_;
+};
+
+#endif /* CONTROLLER_H */
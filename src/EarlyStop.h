@@ -0,0 +1,35 @@
+#ifndef EARLY_STOP_H
+#define EARLY_STOP_H
+
+#include <cmath>
+
+/*
+* Why an evaluation ended before its last frame.
+*  BOUND  the scored |cte| sum already exceeds what the best candidate scored
+*         over the whole run, so this one cannot win any more
+*  CRASH  |cte| exceeded the crash threshold, the car is off the road
+*/
+enum class StopReason {NONE, BOUND, CRASH};
+
+/*
+* When to give up on an evaluation. The defaults never stop early.
+*/
+struct StopPolicy {
+  double bound;       // scored |cte| sum to give up at, e.g. best_err * iters
+  double crash_cte;   // |cte| to give up at [m], 0 disables crash detection
+
+  StopPolicy() : bound(HUGE_VAL), crash_cte(0.0) {}
+};
+
+/*
+* Check one frame given its cte and the scored |cte| sum so far.
+*/
+inline StopReason CheckStop(const StopPolicy& policy, double cte, double err) {
+  if (policy.crash_cte > 0.0 && std::fabs(cte) > policy.crash_cte)
+    return StopReason::CRASH;
+  if (err > policy.bound)
+    return StopReason::BOUND;
+  return StopReason::NONE;
+}
+
+#endif /* EARLY_STOP_H */
@@ -0,0 +1,205 @@
+#include "EvalCache.h"
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+#include "GainSchedule.h"
+#include "Simulation.h"
+
+static const char kCacheMagic[8] = {'P', 'I', 'D', 'E', 'V', 'A', 'L', 'C'};
+static const uint32_t kCacheVersion = 1;
+
+namespace {
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t entries;
+};
+
+struct CacheRecord {
+  uint64_t scenario;
+  uint64_t p[3];
+  double cost;
+};
+
+}  // namespace
+
+EvalCache::EvalCache() : hits_(0), misses_(0) {}
+
+bool EvalCache::Key::operator==(const Key& other) const {
+    return scenario == other.scenario && p[0] == other.p[0] && p[1] == other.p[1] && p[2] == other.p[2];
+}
+
+size_t EvalCache::KeyHash::operator()(const Key& key) const {
+    uint64_t h = key.scenario;
+    for (uint64_t v : key.p)
+        h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return static_cast<size_t>(h);
+}
+
+EvalCache::Key EvalCache::MakeKey(uint64_t scenario, const double p[]) {
+    Key key;
+    key.scenario = scenario;
+    for (int k = 0; k < 3; ++k) {
+        // -0.0 and 0.0 are the same gain
+        const double v = p[k] == 0.0 ? 0.0 : p[k];
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        // Round to nearest on the 36 kept mantissa bits
+        const int drop = 52 - 36;
+        bits = (bits + (uint64_t(1) << (drop - 1))) & ~((uint64_t(1) << drop) - 1);
+        key.p[k] = bits;
+    }
+    return key;
+}
+
+bool EvalCache::Lookup(uint64_t scenario, const double p[], double& cost) {
+    const Key key = MakeKey(scenario, p);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        ++misses_;
+        return false;
+    }
+    ++hits_;
+    cost = it->second;
+    return true;
+}
+
+void EvalCache::Insert(uint64_t scenario, const double p[], double cost) {
+    const Key key = MakeKey(scenario, p);
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[key] = cost;
+}
+
+size_t EvalCache::Size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+bool EvalCache::Load(const std::string& path) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return true;
+
+    CacheHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+        && std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) == 0
+        && header.version == kCacheVersion;
+    std::vector<CacheRecord> records;
+    if (ok) {
+        // Check the entry count against the file before allocating
+        const long offset = ftell(file);
+        ok = fseek(file, 0, SEEK_END) == 0
+            && static_cast<uint64_t>(ftell(file) - offset) / sizeof(CacheRecord) == header.entries
+            && fseek(file, offset, SEEK_SET) == 0;
+    }
+    if (ok) {
+        records.resize(header.entries);
+        ok = records.empty() || fread(records.data(), sizeof(CacheRecord), records.size(), file) == records.size();
+    }
+    fclose(file);
+    if (!ok)
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const CacheRecord& r : records) {
+        Key key;
+        key.scenario = r.scenario;
+        std::memcpy(key.p, r.p, sizeof(key.p));
+        entries_[key] = r.cost;
+    }
+    return true;
+}
+
+bool EvalCache::Save(const std::string& path) {
+    std::vector<CacheRecord> records;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        records.reserve(entries_.size());
+        for (const auto& entry : entries_) {
+            CacheRecord r;
+            r.scenario = entry.first.scenario;
+            std::memcpy(r.p, entry.first.p, sizeof(r.p));
+            r.cost = entry.second;
+            records.push_back(r);
+        }
+    }
+
+    const std::string tmp = path + ".tmp";
+    FILE *file = fopen(tmp.c_str(), "wb");
+    if (!file)
+        return false;
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.version = kCacheVersion;
+    header.entries = records.size();
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && !records.empty())
+        ok = fwrite(records.data(), sizeof(CacheRecord), records.size(), file) == records.size();
+    ok = fflush(file) == 0 && ok;
+    ok = fsync(fileno(file)) == 0 && ok;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+void Fingerprinter::Add(const void* data, size_t n) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < n; ++i) {
+        h_ ^= bytes[i];
+        h_ *= 1099511628211ull;
+    }
+}
+
+void Fingerprinter::Add(const char *name) {
+    // Include the terminator so "ab" + "c" differs from "a" + "bc"
+    Add(name, std::strlen(name) + 1);
+}
+
+void Fingerprinter::Add(const GainSchedule* schedule) {
+    if (!schedule || schedule->Empty()) {
+        Add(0);
+        return;
+    }
+    const std::vector<double>& table = schedule->Table();
+    Add(static_cast<int>(table.size()));
+    Add(table.data(), table.size() * sizeof(double));
+    Add(schedule->MinSpeed());
+    Add(schedule->InvStep());
+}
+
+uint64_t Fingerprint(const Scenario& scenario, const StopPolicy& policy) {
+    Fingerprinter fnv;
+    for (const TrackSegment& segment : scenario.track.segments) {
+        fnv.Add(segment.length);
+        fnv.Add(segment.curvature);
+    }
+    fnv.Add(scenario.track.half_width);
+    const VehicleParams& v = scenario.vehicle;
+    fnv.Add(v.Lf);
+    fnv.Add(v.max_steer);
+    fnv.Add(v.max_accel);
+    fnv.Add(v.drag);
+    fnv.Add(v.dt);
+    fnv.Add(v.cte_noise);
+    fnv.Add(&scenario.seed, sizeof(scenario.seed));
+    fnv.Add(scenario.iters);
+    for (double t : scenario.tParams)
+        fnv.Add(t);
+    fnv.Add(scenario.throttle_mean);
+    fnv.Add(scenario.throttle_max);
+    fnv.Add(static_cast<int>(scenario.anti_windup));
+    fnv.Add(scenario.time_base);
+    fnv.Add(scenario.d_filter_tau);
+    fnv.Add(scenario.control_every);
+    fnv.Add(scenario.schedule);
+    fnv.Add(policy.crash_cte);
+    return fnv.Value();
+}
@@ -0,0 +1,101 @@
+#ifndef EVAL_CACHE_H
+#define EVAL_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class GainSchedule;
+struct Scenario;
+struct StopPolicy;
+
+/*
+* Content-addressed memo of episode costs, (scenario, gains) -> cost.
+*
+* The scenario is reduced to a 64 bit fingerprint of everything that affects
+* an episode (track, vehicle, seed, iters, throttle parameters, controller
+* settings, crash threshold), so costs from different scenarios never mix.
+* Gains are matched after rounding to 36 mantissa bits, which folds the
+* last-bit differences of p + dp - 2 * dp + dp and the like into the same
+* entry. All methods are thread safe.
+*/
+class EvalCache {
+public:
+  EvalCache();
+
+  /*
+  * Look up the cost of gains p under scenario. Returns false on a miss.
+  */
+  bool Lookup(uint64_t scenario, const double p[], double& cost);
+
+  /*
+  * Remember the exact cost of gains p under scenario.
+  */
+  void Insert(uint64_t scenario, const double p[], double cost);
+
+  size_t Size();
+  uint64_t Hits() const { return hits_; }
+  uint64_t Misses() const { return misses_; }
+
+  /*
+  * Add the entries of a file written by Save. A missing file is an empty
+  * cache; returns false only for a corrupt or foreign file.
+  */
+  bool Load(const std::string& path);
+
+  /*
+  * Write all entries to path.tmp and rename it over path.
+  */
+  bool Save(const std::string& path);
+
+private:
+  struct Key {
+    uint64_t scenario;
+    uint64_t p[3];
+    bool operator==(const Key& other) const;
+  };
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  std::mutex mutex_;
+  std::unordered_map<Key, double, KeyHash> entries_;
+  std::atomic<uint64_t> hits_;
+  std::atomic<uint64_t> misses_;
+
+  static Key MakeKey(uint64_t scenario, const double p[]);
+};
+
+/*
+* FNV-1a hash built up from the settings an evaluation depends on.
+*/
+class Fingerprinter {
+public:
+  Fingerprinter() : h_(1469598103934665603ull) {}
+
+  void Add(const void* data, size_t n);
+  void Add(const char *name);
+  void Add(double x) { Add(&x, sizeof(x)); }
+  void Add(int x) { Add(&x, sizeof(x)); }
+  /*
+  * The table of a gain schedule, or a marker for none.
+  */
+  void Add(const GainSchedule* schedule);
+
+  uint64_t Value() const { return h_; }
+
+private:
+  uint64_t h_;
+};
+
+/*
+* Fingerprint of everything in a Scenario and the policy that changes an
+* exact RunEpisode cost. Only the crash threshold of the policy matters: the
+* bound only stops episodes whose cost isn't cached anyway.
+*/
+uint64_t Fingerprint(const Scenario& scenario, const StopPolicy& policy);
+
+#endif /* EVAL_CACHE_H */
@@ -0,0 +1,103 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <cstdint>
+#include <limits>
+#include "BasicPID.h"
+
+/*
+* Signed Q-format fixed-point number with FracBits fractional bits stored in
+* Raw, using Wide for intermediate products. All arithmetic is integer only
+* and saturates at the limits of Raw instead of wrapping, so results are
+* bit-exact on every host and safe on targets without an FPU.
+*
+*   Fixed<16>                         Q15.16 in an int32_t
+*   Fixed<24>                         Q7.24 in an int32_t
+*   Fixed<11, int16_t, int32_t>       Q4.11 in an int16_t
+*
+* Conversion from double is only meant for setting up gains and feeding test
+* data; on a target without an FPU use FromRaw.
+*/
+template <int FracBits, typename Raw = int32_t, typename Wide = int64_t>
+class Fixed {
+public:
+  static_assert(FracBits > 0 && FracBits < std::numeric_limits<Raw>::digits,
+                "FracBits must leave room for the sign bit");
+  static_assert(std::numeric_limits<Wide>::digits >= 2 * std::numeric_limits<Raw>::digits,
+                "Wide must hold the product of two Raw values");
+
+  Raw raw;
+
+  Fixed() : raw(0) {}
+
+  // Round to nearest and saturate
+  Fixed(double value) {
+    const double scaled = value * One();
+    if (scaled >= static_cast<double>(std::numeric_limits<Raw>::max()))
+      raw = std::numeric_limits<Raw>::max();
+    else if (scaled <= static_cast<double>(std::numeric_limits<Raw>::min()))
+      raw = std::numeric_limits<Raw>::min();
+    else
+      raw = static_cast<Raw>(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+  }
+
+  static Fixed FromRaw(Raw raw) {
+    Fixed f;
+    f.raw = raw;
+    return f;
+  }
+
+  double ToDouble() const { return static_cast<double>(raw) / One(); }
+
+  static constexpr Wide One() { return static_cast<Wide>(1) << FracBits; }
+
+  friend Fixed operator+(Fixed a, Fixed b) {
+    return FromRaw(Saturate(static_cast<Wide>(a.raw) + b.raw));
+  }
+
+  friend Fixed operator-(Fixed a, Fixed b) {
+    return FromRaw(Saturate(static_cast<Wide>(a.raw) - b.raw));
+  }
+
+  // Rounds the product half away from zero before dropping the extra bits
+  friend Fixed operator*(Fixed a, Fixed b) {
+    const Wide product = static_cast<Wide>(a.raw) * b.raw;
+    const Wide half = static_cast<Wide>(1) << (FracBits - 1);
+    const Wide rounded = product >= 0 ? (product + half) / One() : (product - half) / One();
+    return FromRaw(Saturate(rounded));
+  }
+
+  Fixed operator-() const {
+    return FromRaw(Saturate(-static_cast<Wide>(raw)));
+  }
+
+  friend bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+  friend bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+  friend bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+  friend bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+
+private:
+  static Raw Saturate(Wide value) {
+    if (value > std::numeric_limits<Raw>::max())
+      return std::numeric_limits<Raw>::max();
+    if (value < std::numeric_limits<Raw>::min())
+      return std::numeric_limits<Raw>::min();
+    return static_cast<Raw>(value);
+  }
+};
+
+/*
+* Fixed-point PID controller, the integer counterpart of PID.
+*/
+template <int FracBits, typename Raw = int32_t, typename Wide = int64_t>
+using FixedPID = BasicPID<Fixed<FracBits, Raw, Wide> >;
+
+/*
+* Clamp a controller output to [lo, hi], e.g. the [-1, 1] steering range.
+*/
+template <typename T>
+T ClampOutput(T value, T lo, T hi) {
+  return value < lo ? lo : (value > hi ? hi : value);
+}
+
+#endif /* FIXED_POINT_H */
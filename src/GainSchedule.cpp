@@ -0,0 +1,80 @@
+#include "GainSchedule.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+GainSchedule::GainSchedule() : min_speed_(0.0), inv_step_(0.0), last_(0.0) {}
+
+bool GainSchedule::Build(std::vector<GainPoint> points, double resolution) {
+    if (points.empty() || !(resolution > 0.0))
+        return false;
+    std::sort(points.begin(), points.end(),
+              [](const GainPoint& a, const GainPoint& b) { return a.speed < b.speed; });
+
+    const double lo = points.front().speed;
+    const double span = points.back().speed - lo;
+    const size_t cells = static_cast<size_t>(std::ceil(span / resolution - 1e-9)) + 1;
+    const double step = cells > 1 ? span / (cells - 1) : 0.0;
+
+    // Sample the breakpoints' piecewise-linear curve at every grid point
+    std::vector<GainPoint> grid(cells);
+    size_t seg = 0;
+    for (size_t i = 0; i < cells; ++i) {
+        const double s = i + 1 == cells ? points.back().speed : lo + i * step;
+        while (seg + 1 < points.size() && points[seg + 1].speed < s)
+            ++seg;
+        const GainPoint& a = points[seg];
+        const GainPoint& b = points[std::min(seg + 1, points.size() - 1)];
+        const double f = b.speed > a.speed ? std::min(1.0, std::max(0.0, (s - a.speed) / (b.speed - a.speed))) : 0.0;
+        grid[i] = GainPoint{s, a.Kp + f * (b.Kp - a.Kp), a.Ki + f * (b.Ki - a.Ki), a.Kd + f * (b.Kd - a.Kd)};
+    }
+
+    table_.assign(cells * kStride, 0.0);
+    for (size_t i = 0; i < cells; ++i) {
+        double *cell = &table_[i * kStride];
+        cell[0] = grid[i].Kp;
+        cell[1] = grid[i].Ki;
+        cell[2] = grid[i].Kd;
+        // The last cell has zero slope, so clamping to it is exact
+        if (i + 1 < cells) {
+            cell[3] = grid[i + 1].Kp - grid[i].Kp;
+            cell[4] = grid[i + 1].Ki - grid[i].Ki;
+            cell[5] = grid[i + 1].Kd - grid[i].Kd;
+        }
+    }
+    min_speed_ = lo;
+    inv_step_ = step > 0.0 ? 1.0 / step : 0.0;
+    last_ = static_cast<double>(cells - 1);
+    return true;
+}
+
+bool GainSchedule::Parse(const char *spec, double resolution) {
+    std::vector<GainPoint> points;
+    const char *p = spec;
+    while (*p) {
+        GainPoint g;
+        char *end;
+        g.speed = std::strtod(p, &end);
+        if (end == p || *end != ':')
+            return false;
+        double *k[] = {&g.Kp, &g.Ki, &g.Kd};
+        p = end + 1;
+        for (int j = 0; j < 3; ++j) {
+            *k[j] = std::strtod(p, &end);
+            if (end == p || (j < 2 && *end != ','))
+                return false;
+            p = j < 2 ? end + 1 : end;
+        }
+        points.push_back(g);
+        if (*p == ';')
+            ++p;
+        else if (*p)
+            return false;
+    }
+    return Build(points, resolution);
+}
+
+void GainSchedule::LookupBatch(const double* speed, double* Kp, double* Ki, double* Kd, size_t n) const {
+    for (size_t i = 0; i < n; ++i)
+        Lookup(speed[i], Kp[i], Ki[i], Kd[i]);
+}
@@ -0,0 +1,88 @@
+#ifndef GAIN_SCHEDULE_H
+#define GAIN_SCHEDULE_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+* One breakpoint of a gain schedule: the gains to use at a speed [mph].
+*/
+struct GainPoint {
+  double speed;
+  double Kp;
+  double Ki;
+  double Kd;
+};
+
+/*
+* Kp/Ki/Kd as a piecewise-linear function of speed.
+*
+* The breakpoints are resampled onto a uniform grid, and each grid cell is
+* stored interleaved as {Kp, Ki, Kd, dKp, dKi, dKd}. That way a lookup is one
+* multiply to find the cell, a min/max clamp and three base + fraction * slope
+* evaluations with no branches, all from a single 48 byte cell. Speeds
+* outside the breakpoints use the gains of the nearest end, a NaN speed those
+* of the lowest breakpoint.
+*/
+class GainSchedule {
+public:
+  GainSchedule();
+
+  /*
+  * Build the table from breakpoints (any order). The grid spacing is at most
+  * resolution mph; breakpoints on the grid are reproduced exactly. Returns
+  * false if points is empty or resolution is not positive.
+  */
+  bool Build(std::vector<GainPoint> points, double resolution = 1.0);
+
+  /*
+  * Build from "speed:Kp,Ki,Kd;speed:Kp,Ki,Kd;...".
+  */
+  bool Parse(const char *spec, double resolution = 1.0);
+
+  bool Empty() const { return table_.empty(); }
+
+  /*
+  * Number of grid cells.
+  */
+  size_t Cells() const { return table_.size() / kStride; }
+
+  /*
+  * The interleaved cells and the grid they sit on, e.g. to fingerprint a
+  * schedule.
+  */
+  const std::vector<double>& Table() const { return table_; }
+  double MinSpeed() const { return min_speed_; }
+  double InvStep() const { return inv_step_; }
+
+  /*
+  * Gains at one speed.
+  */
+  void Lookup(double speed, double& Kp, double& Ki, double& Kd) const {
+    double t = (speed - min_speed_) * inv_step_;
+    // Written so a NaN speed (or inf * 0) lands on the first cell
+    t = t > 0.0 ? t : 0.0;
+    t = t > last_ ? last_ : t;
+    const size_t i = static_cast<size_t>(t);
+    const double f = t - static_cast<double>(i);
+    const double *cell = &table_[i * kStride];
+    Kp = cell[0] + f * cell[3];
+    Ki = cell[1] + f * cell[4];
+    Kd = cell[2] + f * cell[5];
+  }
+
+  /*
+  * Gains for n speeds into the Kp, Ki and Kd arrays.
+  */
+  void LookupBatch(const double* speed, double* Kp, double* Ki, double* Kd, size_t n) const;
+
+private:
+  static const size_t kStride = 6;
+
+  std::vector<double> table_;
+  double min_speed_;
+  double inv_step_;
+  double last_;
+};
+
+#endif /* GAIN_SCHEDULE_H */
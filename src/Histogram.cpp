@@ -0,0 +1,70 @@
+#include "Histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+LatencyHistogram::LatencyHistogram() {
+    Reset();
+}
+
+int LatencyHistogram::Index(uint64_t ns) {
+    if (ns < static_cast<uint64_t>(kSubBuckets))
+        return static_cast<int>(ns);
+    const int msb = 63 - __builtin_clzll(ns);
+    const int shift = msb - kSubBucketBits;
+    return (shift + 1) * kSubBuckets + static_cast<int>((ns >> shift) - kSubBuckets);
+}
+
+uint64_t LatencyHistogram::UpperBound(int index) {
+    if (index < kSubBuckets)
+        return index;
+    const int shift = index / kSubBuckets - 1;
+    const uint64_t sub = index % kSubBuckets + kSubBuckets;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t ns) {
+    ++counts_[Index(ns)];
+    ++count_;
+    sum_ += ns;
+    if (ns > max_)
+        max_ = ns;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    for (int i = 0; i < kBuckets; ++i)
+        counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::Reset() {
+    std::memset(counts_, 0, sizeof(counts_));
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+}
+
+uint64_t LatencyHistogram::Quantile(double q) const {
+    if (count_ == 0)
+        return 0;
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * count_)));
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += counts_[i];
+        if (seen >= rank)
+            return std::min(UpperBound(i), max_);
+    }
+    return max_;
+}
+
+std::string LatencyHistogram::Summary() const {
+    char buf[160];
+    std::snprintf(buf, sizeof(buf),
+                  "n=%llu mean=%.2fus p50=%.2fus p99=%.2fus p99.9=%.2fus max=%.2fus",
+                  static_cast<unsigned long long>(count_), Mean() / 1e3,
+                  Quantile(0.5) / 1e3, Quantile(0.99) / 1e3, Quantile(0.999) / 1e3, max_ / 1e3);
+    return buf;
+}
@@ -0,0 +1,61 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+* Monotonic clock in nanoseconds, the unit the histogram records.
+*/
+inline int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+* HDR-style latency histogram over nanosecond values.
+*
+* Buckets are log-linear: every power of two is split into 32 equal
+* sub-buckets, so any recorded value is reported within about 3% while the
+* whole range from 1 ns to minutes fits in a fixed array. Recording is a few
+* integer instructions and never allocates.
+*/
+class LatencyHistogram {
+public:
+  LatencyHistogram();
+
+  void Record(uint64_t ns);
+  void Merge(const LatencyHistogram& other);
+  void Reset();
+
+  uint64_t Count() const { return count_; }
+  uint64_t Max() const { return max_; }
+  double Mean() const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+
+  /*
+  * Smallest bucket upper bound covering fraction q (0..1) of the values.
+  */
+  uint64_t Quantile(double q) const;
+
+  /*
+  * One line summary: count, mean, p50, p99, p99.9 and max in microseconds.
+  */
+  std::string Summary() const;
+
+private:
+  static const int kSubBucketBits = 5;
+  static const int kSubBuckets = 1 << kSubBucketBits;
+  static const int kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  uint64_t counts_[kBuckets];
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t max_;
+
+  static int Index(uint64_t ns);
+  static uint64_t UpperBound(int index);
+};
+
+#endif /* HISTOGRAM_H */
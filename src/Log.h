@@ -0,0 +1,87 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <iostream>
+#include <mutex>
+
+/*
+* Compile-time log levels. Messages above PID_LOG_LEVEL expand to an empty
+* statement, so neither the stream insertion nor its arguments cost anything
+* in the control loop. Set the level with -DPID_LOG_LEVEL=<NONE|ERROR|INFO|DEBUG>
+* at cmake time.
+*/
+#define PID_LOG_LEVEL_NONE 0
+#define PID_LOG_LEVEL_ERROR 1
+#define PID_LOG_LEVEL_INFO 2
+#define PID_LOG_LEVEL_DEBUG 3
+
+#ifndef PID_LOG_LEVEL
+#define PID_LOG_LEVEL PID_LOG_LEVEL_INFO
+#endif
+
+/*
+* Info lines are rare lifecycle messages (listening, connects, session
+* reports) that have to show up at once and survive a Ctrl-C, so they are
+* flushed. Errors go to the unbuffered std::cerr, which flushes std::cout
+* first so the two stay ordered. Only the per-frame debug output ends in
+* '\n' and stays in the stream buffer.
+*/
+#define PID_LOG_NOTHING do {} while (0)
+
+/*
+* Serializes output from several event loop threads. std::cout is no longer
+* synchronized once InitLogging() has run, so every message takes this lock.
+*/
+inline std::mutex& LogMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+/*
+* The result of a run (tuning answer, replay statistics, load report) is what
+* the user asked for, so it is printed whatever PID_LOG_LEVEL is, and flushed.
+*/
+#define LOG_RESULT(msg) \
+  do { std::lock_guard<std::mutex> pid_log_lock_(LogMutex()); std::cout << msg << std::endl; } while (0)
+
+#if PID_LOG_LEVEL >= PID_LOG_LEVEL_ERROR
+#define LOG_ERROR(msg) \
+  do { std::lock_guard<std::mutex> pid_log_lock_(LogMutex()); std::cerr << msg << std::endl; } while (0)
+#else
+#define LOG_ERROR(msg) PID_LOG_NOTHING
+#endif
+
+#if PID_LOG_LEVEL >= PID_LOG_LEVEL_INFO
+#define LOG_INFO(msg) \
+  do { std::lock_guard<std::mutex> pid_log_lock_(LogMutex()); std::cout << msg << std::endl; } while (0)
+#else
+#define LOG_INFO(msg) PID_LOG_NOTHING
+#endif
+
+#if PID_LOG_LEVEL >= PID_LOG_LEVEL_DEBUG
+#define LOG_DEBUG(msg) \
+  do { std::lock_guard<std::mutex> pid_log_lock_(LogMutex()); std::cout << msg << '\n'; } while (0)
+/*
+* Log only every n-th pass through this call site, for per-frame messages.
+*/
+#define LOG_DEBUG_EVERY_N(n, msg) \
+  do { \
+    static thread_local unsigned long pid_log_count_ = 0; \
+    if (pid_log_count_++ % (n) == 0) \
+      LOG_DEBUG(msg); \
+  } while (0)
+#else
+#define LOG_DEBUG(msg) PID_LOG_NOTHING
+#define LOG_DEBUG_EVERY_N(n, msg) PID_LOG_NOTHING
+#endif
+
+/*
+* Decouple std::cout from C stdio so it gets its own fully buffered stream
+* instead of the line buffering stdout uses on a terminal. Call once at the
+* start of main, before anything is printed.
+*/
+inline void InitLogging() {
+  std::ios::sync_with_stdio(false);
+}
+
+#endif /* LOG_H */
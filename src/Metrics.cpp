@@ -0,0 +1,162 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+RunningStats::RunningStats() {
+    Reset();
+}
+
+void RunningStats::Reset() {
+    count_ = 0;
+    mean_ = 0.0;
+    m2_ = 0.0;
+    min_ = HUGE_VAL;
+    max_ = -HUGE_VAL;
+}
+
+void RunningStats::Add(double x) {
+    ++count_;
+    const double delta = x - mean_;
+    mean_ += delta / count_;
+    m2_ += delta * (x - mean_);
+    min_ = fmin(min_, x);
+    max_ = fmax(max_, x);
+}
+
+double RunningStats::StdDev() const {
+    return sqrt(Variance());
+}
+
+double RunningStats::Rms() const {
+    return sqrt(mean_ * mean_ + Variance());
+}
+
+P2Quantile::P2Quantile(double q) : q_(q) {
+    Reset();
+}
+
+void P2Quantile::Reset() {
+    count_ = 0;
+    for (int i = 0; i < 5; ++i) {
+        height_[i] = 0.0;
+        pos_[i] = i + 1;
+    }
+    desired_[0] = 1;
+    desired_[1] = 1 + 2 * q_;
+    desired_[2] = 1 + 4 * q_;
+    desired_[3] = 3 + 2 * q_;
+    desired_[4] = 5;
+    step_[0] = 0;
+    step_[1] = q_ / 2;
+    step_[2] = q_;
+    step_[3] = (1 + q_) / 2;
+    step_[4] = 1;
+}
+
+double P2Quantile::Parabolic(int i, double d) const {
+    return height_[i] + d / (pos_[i + 1] - pos_[i - 1]) *
+        ((pos_[i] - pos_[i - 1] + d) * (height_[i + 1] - height_[i]) / (pos_[i + 1] - pos_[i]) +
+         (pos_[i + 1] - pos_[i] - d) * (height_[i] - height_[i - 1]) / (pos_[i] - pos_[i - 1]));
+}
+
+double P2Quantile::Linear(int i, double d) const {
+    const int j = i + static_cast<int>(d);
+    return height_[i] + d * (height_[j] - height_[i]) / (pos_[j] - pos_[i]);
+}
+
+void P2Quantile::Add(double x) {
+    // Collect the first five values as the initial marker heights
+    if (count_ < 5) {
+        height_[count_++] = x;
+        if (count_ == 5)
+            std::sort(height_, height_ + 5);
+        return;
+    }
+    ++count_;
+
+    // Find the cell x falls in, extending the extreme markers if needed
+    int k;
+    if (x < height_[0]) {
+        height_[0] = x;
+        k = 0;
+    } else if (x >= height_[4]) {
+        height_[4] = fmax(height_[4], x);
+        k = 3;
+    } else {
+        k = 0;
+        while (k < 3 && x >= height_[k + 1])
+            ++k;
+    }
+
+    for (int i = k + 1; i < 5; ++i)
+        pos_[i] += 1;
+    for (int i = 0; i < 5; ++i)
+        desired_[i] += step_[i];
+
+    // Move the middle markers towards their desired positions
+    for (int i = 1; i < 4; ++i) {
+        const double d = desired_[i] - pos_[i];
+        if ((d >= 1 && pos_[i + 1] - pos_[i] > 1) || (d <= -1 && pos_[i - 1] - pos_[i] < -1)) {
+            const double sign = d > 0 ? 1.0 : -1.0;
+            double h = Parabolic(i, sign);
+            if (h <= height_[i - 1] || h >= height_[i + 1])
+                h = Linear(i, sign);
+            height_[i] = h;
+            pos_[i] += sign;
+        }
+    }
+}
+
+double P2Quantile::Value() const {
+    if (count_ >= 5)
+        return height_[2];
+    if (count_ == 0)
+        return 0.0;
+    double sorted[5];
+    std::copy(height_, height_ + count_, sorted);
+    std::sort(sorted, sorted + count_);
+    return sorted[static_cast<int>(std::min<double>(count_ - 1, floor(q_ * count_)))];
+}
+
+DriveMetrics::DriveMetrics() : cte_p50(0.5), cte_p95(0.95), cte_p99(0.99) {
+    Reset();
+}
+
+void DriveMetrics::Reset() {
+    abs_cte.Reset();
+    cte.Reset();
+    speed.Reset();
+    jerk.Reset();
+    cte_p50.Reset();
+    cte_p95.Reset();
+    cte_p99.Reset();
+    steer_[0] = steer_[1] = 0.0;
+}
+
+void DriveMetrics::Add(double cte, double speed, double steer) {
+    const double abs_cte = fabs(cte);
+    this->abs_cte.Add(abs_cte);
+    this->cte.Add(cte);
+    this->speed.Add(speed);
+    cte_p50.Add(abs_cte);
+    cte_p95.Add(abs_cte);
+    cte_p99.Add(abs_cte);
+
+    // Second difference of the steering command, needs two earlier frames
+    if (Frames() > 2)
+        jerk.Add(steer - 2 * steer_[1] + steer_[0]);
+    steer_[0] = steer_[1];
+    steer_[1] = steer;
+}
+
+std::string DriveMetrics::Summary() const {
+    char buf[320];
+    snprintf(buf, sizeof(buf),
+             "frames=%llu |cte| mean=%.4f rms=%.4f max=%.4f p50=%.4f p95=%.4f p99=%.4f"
+             " cte sd=%.4f speed mean=%.2f sd=%.2f max=%.2f jerk rms=%.5f",
+             static_cast<unsigned long long>(Frames()), abs_cte.Mean(), abs_cte.Rms(),
+             Frames() ? abs_cte.Max() : 0.0, cte_p50.Value(), cte_p95.Value(), cte_p99.Value(),
+             cte.StdDev(), speed.Mean(), speed.StdDev(), Frames() ? speed.Max() : 0.0, jerk.Rms());
+    return buf;
+}
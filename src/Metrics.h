@@ -0,0 +1,107 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstdint>
+#include <string>
+
+/*
+* Running count, mean, variance (Welford), RMS, min and max of a stream.
+*/
+class RunningStats {
+public:
+  RunningStats();
+
+  void Add(double x);
+  void Reset();
+
+  uint64_t Count() const { return count_; }
+  double Mean() const { return mean_; }
+  double Min() const { return min_; }
+  double Max() const { return max_; }
+
+  /*
+  * Population variance and standard deviation.
+  */
+  double Variance() const { return count_ ? m2_ / count_ : 0.0; }
+  double StdDev() const;
+
+  /*
+  * Root mean square, sqrt(mean^2 + variance).
+  */
+  double Rms() const;
+
+private:
+  uint64_t count_;
+  double mean_;
+  double m2_;
+  double min_;
+  double max_;
+};
+
+/*
+* Streaming estimate of one quantile with the P-square algorithm (Jain and
+* Chlamtac, 1985). Keeps five markers whose heights are adjusted with
+* piecewise-parabolic interpolation, so memory and time per value are
+* constant.
+*/
+class P2Quantile {
+public:
+  /*
+  * q is the quantile to track, 0..1.
+  */
+  explicit P2Quantile(double q = 0.5);
+
+  void Add(double x);
+  void Reset();
+
+  uint64_t Count() const { return count_; }
+
+  /*
+  * The current estimate. Exact while fewer than five values were seen.
+  */
+  double Value() const;
+
+private:
+  double q_;
+  uint64_t count_;
+  double height_[5];
+  double pos_[5];
+  double desired_[5];
+  double step_[5];
+
+  double Parabolic(int i, double d) const;
+  double Linear(int i, double d) const;
+};
+
+/*
+* Per-session driving quality, updated in O(1) per telemetry frame: |cte|,
+* signed cte, speed, steering jerk (second difference of the steering
+* command per frame) and the p50/p95/p99 of |cte|.
+*/
+class DriveMetrics {
+public:
+  DriveMetrics();
+
+  void Add(double cte, double speed, double steer);
+  void Reset();
+
+  uint64_t Frames() const { return abs_cte.Count(); }
+
+  RunningStats abs_cte;
+  RunningStats cte;
+  RunningStats speed;
+  RunningStats jerk;
+  P2Quantile cte_p50;
+  P2Quantile cte_p95;
+  P2Quantile cte_p99;
+
+  /*
+  * One line summary of the above.
+  */
+  std::string Summary() const;
+
+private:
+  double steer_[2];
+};
+
+#endif /* METRICS_H */
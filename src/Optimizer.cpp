@@ -0,0 +1,362 @@
+#include "Optimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+Optimizer::Optimizer(const std::vector<double>& x0, const std::vector<double>& step0, unsigned seed)
+    : dim_(x0.size()), x0_(x0), step0_(step0), rng_(seed), best_(x0), best_cost_(HUGE_VAL) {}
+
+Optimizer::~Optimizer() {}
+
+void Optimizer::Tell(const std::vector<double>& candidates, const std::vector<double>& cost) {
+    for (size_t k = 0; k < cost.size(); ++k) {
+        if (cost[k] < best_cost_) {
+            best_cost_ = cost[k];
+            best_.assign(candidates.begin() + k * dim_, candidates.begin() + (k + 1) * dim_);
+        }
+    }
+    Update(candidates, cost);
+}
+
+// Order of the costs, best first
+static std::vector<size_t> Ranking(const std::vector<double>& cost) {
+    std::vector<size_t> order(cost.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return cost[a] < cost[b]; });
+    return order;
+}
+
+// Eigen decomposition of the symmetric n x n matrix a with cyclic Jacobi
+// rotations. Fine for the handful of dimensions tuned here.
+static void SymmetricEigen(std::vector<double> a, size_t n, std::vector<double>& values, std::vector<double>& vectors) {
+    vectors.assign(n * n, 0.0);
+    for (size_t i = 0; i < n; ++i)
+        vectors[i * n + i] = 1.0;
+
+    for (int sweep = 0; sweep < 50; ++sweep) {
+        double off = 0.0;
+        for (size_t p = 0; p < n; ++p)
+            for (size_t q = p + 1; q < n; ++q)
+                off += a[p * n + q] * a[p * n + q];
+        if (off < 1e-30)
+            break;
+
+        for (size_t p = 0; p < n; ++p) {
+            for (size_t q = p + 1; q < n; ++q) {
+                const double apq = a[p * n + q];
+                if (std::fabs(apq) < 1e-300)
+                    continue;
+                const double theta = (a[q * n + q] - a[p * n + p]) / (2 * apq);
+                const double t = (theta >= 0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1));
+                const double c = 1 / std::sqrt(t * t + 1);
+                const double s = t * c;
+                for (size_t k = 0; k < n; ++k) {
+                    const double akp = a[k * n + p], akq = a[k * n + q];
+                    a[k * n + p] = c * akp - s * akq;
+                    a[k * n + q] = s * akp + c * akq;
+                }
+                for (size_t k = 0; k < n; ++k) {
+                    const double apk = a[p * n + k], aqk = a[q * n + k];
+                    a[p * n + k] = c * apk - s * aqk;
+                    a[q * n + k] = s * apk + c * aqk;
+                }
+                for (size_t k = 0; k < n; ++k) {
+                    const double vkp = vectors[k * n + p], vkq = vectors[k * n + q];
+                    vectors[k * n + p] = c * vkp - s * vkq;
+                    vectors[k * n + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    values.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        values[i] = a[i * n + i];
+}
+
+CMAES::CMAES(const std::vector<double>& x0, const std::vector<double>& step0, size_t population, unsigned seed)
+    : Optimizer(x0, step0, seed), mean_(x0), sigma_(1.0), generation_(0) {
+    const size_t n = dim_;
+    lambda_ = std::max<size_t>(4 + static_cast<size_t>(3 * std::log(static_cast<double>(n))), population);
+    mu_ = lambda_ / 2;
+    weights_.resize(mu_);
+    for (size_t i = 0; i < mu_; ++i)
+        weights_[i] = std::log(mu_ + 0.5) - std::log(i + 1.0);
+    const double sum = std::accumulate(weights_.begin(), weights_.end(), 0.0);
+    double sum_sq = 0.0;
+    for (double& w : weights_) {
+        w /= sum;
+        sum_sq += w * w;
+    }
+    mueff_ = 1.0 / sum_sq;
+
+    cc_ = (4 + mueff_ / n) / (n + 4 + 2 * mueff_ / n);
+    cs_ = (mueff_ + 2) / (n + mueff_ + 5);
+    c1_ = 2 / ((n + 1.3) * (n + 1.3) + mueff_);
+    cmu_ = std::min(1 - c1_, 2 * (mueff_ - 2 + 1 / mueff_) / ((n + 2.0) * (n + 2.0) + mueff_));
+    damps_ = 1 + 2 * std::max(0.0, std::sqrt((mueff_ - 1) / (n + 1)) - 1) + cs_;
+    chin_ = std::sqrt(static_cast<double>(n)) * (1 - 1.0 / (4 * n) + 1.0 / (21.0 * n * n));
+
+    // sigma = 1 and C = diag(step0^2), so the first samples are x0 +/- step0
+    C_.assign(n * n, 0.0);
+    for (size_t i = 0; i < n; ++i)
+        C_[i * n + i] = step0[i] * step0[i];
+    pc_.assign(n, 0.0);
+    ps_.assign(n, 0.0);
+    Decompose();
+}
+
+void CMAES::Decompose() {
+    const size_t n = dim_;
+    SymmetricEigen(C_, n, D_, B_);
+    for (double& d : D_)
+        d = std::sqrt(std::max(d, 1e-300));
+}
+
+void CMAES::Ask(std::vector<double>& candidates) {
+    const size_t n = dim_;
+    std::normal_distribution<double> normal;
+    candidates.resize(lambda_ * n);
+    std::vector<double> z(n);
+    for (size_t k = 0; k < lambda_; ++k) {
+        for (size_t i = 0; i < n; ++i)
+            z[i] = D_[i] * normal(rng_);
+        for (size_t i = 0; i < n; ++i) {
+            double y = 0.0;
+            for (size_t j = 0; j < n; ++j)
+                y += B_[i * n + j] * z[j];
+            candidates[k * n + i] = mean_[i] + sigma_ * y;
+        }
+    }
+}
+
+void CMAES::Update(const std::vector<double>& candidates, const std::vector<double>& cost) {
+    const size_t n = dim_;
+    const std::vector<size_t> order = Ranking(cost);
+    ++generation_;
+
+    // Recombine the mu best into the new mean
+    std::vector<double> old_mean = mean_;
+    std::fill(mean_.begin(), mean_.end(), 0.0);
+    for (size_t r = 0; r < mu_; ++r)
+        for (size_t i = 0; i < n; ++i)
+            mean_[i] += weights_[r] * candidates[order[r] * n + i];
+
+    std::vector<double> y_w(n);
+    for (size_t i = 0; i < n; ++i)
+        y_w[i] = (mean_[i] - old_mean[i]) / sigma_;
+
+    // C^-1/2 y_w = B D^-1 B^T y_w
+    std::vector<double> bt(n), inv_sqrt(n);
+    for (size_t j = 0; j < n; ++j) {
+        double s = 0.0;
+        for (size_t i = 0; i < n; ++i)
+            s += B_[i * n + j] * y_w[i];
+        bt[j] = s / D_[j];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        double s = 0.0;
+        for (size_t j = 0; j < n; ++j)
+            s += B_[i * n + j] * bt[j];
+        inv_sqrt[i] = s;
+    }
+
+    // Evolution paths
+    const double cs_norm = std::sqrt(cs_ * (2 - cs_) * mueff_);
+    double ps_len = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        ps_[i] = (1 - cs_) * ps_[i] + cs_norm * inv_sqrt[i];
+        ps_len += ps_[i] * ps_[i];
+    }
+    ps_len = std::sqrt(ps_len);
+    const double hsig_lhs = ps_len / std::sqrt(1 - std::pow(1 - cs_, 2.0 * generation_)) / chin_;
+    const bool hsig = hsig_lhs < 1.4 + 2.0 / (n + 1);
+    const double cc_norm = std::sqrt(cc_ * (2 - cc_) * mueff_);
+    for (size_t i = 0; i < n; ++i)
+        pc_[i] = (1 - cc_) * pc_[i] + (hsig ? cc_norm * y_w[i] : 0.0);
+
+    // Rank-one and rank-mu covariance update
+    const double delta = hsig ? 0.0 : cc_ * (2 - cc_);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            double rank_mu = 0.0;
+            for (size_t r = 0; r < mu_; ++r) {
+                const double *x = &candidates[order[r] * n];
+                rank_mu += weights_[r] * (x[i] - old_mean[i]) * (x[j] - old_mean[j]);
+            }
+            rank_mu /= sigma_ * sigma_;
+            C_[i * n + j] = (1 - c1_ - cmu_) * C_[i * n + j]
+                + c1_ * (pc_[i] * pc_[j] + delta * C_[i * n + j])
+                + cmu_ * rank_mu;
+        }
+    }
+
+    sigma_ *= std::exp((cs_ / damps_) * (ps_len / chin_ - 1));
+    Decompose();
+}
+
+bool CMAES::Converged(double tol) const {
+    return sigma_ * *std::max_element(D_.begin(), D_.end()) < tol;
+}
+
+NelderMead::NelderMead(const std::vector<double>& x0, const std::vector<double>& step0)
+    : Optimizer(x0, step0), phase_(Phase::INIT) {
+    const size_t n = dim_;
+    vertices_.resize((n + 1) * n);
+    for (size_t v = 0; v <= n; ++v)
+        for (size_t i = 0; i < n; ++i)
+            vertices_[v * n + i] = x0[i] + (v > 0 && v - 1 == i ? step0[i] : 0.0);
+    costs_.assign(n + 1, HUGE_VAL);
+}
+
+void NelderMead::Sort() {
+    const size_t n = dim_;
+    const std::vector<size_t> order = Ranking(costs_);
+    std::vector<double> vertices(vertices_.size()), costs(costs_.size());
+    for (size_t r = 0; r <= n; ++r) {
+        std::copy(&vertices_[order[r] * n], &vertices_[order[r] * n] + n, &vertices[r * n]);
+        costs[r] = costs_[order[r]];
+    }
+    vertices_.swap(vertices);
+    costs_.swap(costs);
+}
+
+void NelderMead::Ask(std::vector<double>& candidates) {
+    const size_t n = dim_;
+    if (phase_ == Phase::INIT) {
+        candidates = vertices_;
+    } else if (phase_ == Phase::SHRINK) {
+        // Every vertex but the best halfway towards the best
+        candidates.resize(n * n);
+        for (size_t v = 1; v <= n; ++v)
+            for (size_t i = 0; i < n; ++i)
+                candidates[(v - 1) * n + i] = vertices_[i] + 0.5 * (vertices_[v * n + i] - vertices_[i]);
+    } else {
+        // Reflection, expansion, outside and inside contraction of the worst
+        //  vertex through the centroid of the others
+        candidates.resize(4 * n);
+        for (size_t i = 0; i < n; ++i) {
+            double c = 0.0;
+            for (size_t v = 0; v < n; ++v)
+                c += vertices_[v * n + i];
+            c /= n;
+            const double d = c - vertices_[n * n + i];
+            candidates[0 * n + i] = c + d;
+            candidates[1 * n + i] = c + 2 * d;
+            candidates[2 * n + i] = c + 0.5 * d;
+            candidates[3 * n + i] = c - 0.5 * d;
+        }
+    }
+}
+
+void NelderMead::Update(const std::vector<double>& candidates, const std::vector<double>& cost) {
+    const size_t n = dim_;
+    if (phase_ == Phase::INIT) {
+        costs_ = cost;
+        Sort();
+        phase_ = Phase::STEP;
+        return;
+    }
+    if (phase_ == Phase::SHRINK) {
+        std::copy(candidates.begin(), candidates.end(), vertices_.begin() + n);
+        std::copy(cost.begin(), cost.end(), costs_.begin() + 1);
+        Sort();
+        phase_ = Phase::STEP;
+        return;
+    }
+
+    const double fr = cost[0], fe = cost[1], foc = cost[2], fic = cost[3];
+    int accept = -1;
+    if (fr < costs_[0])
+        accept = fe < fr ? 1 : 0;
+    else if (fr < costs_[n - 1])
+        accept = 0;
+    else if (fr < costs_[n])
+        accept = foc <= fr ? 2 : -1;
+    else
+        accept = fic < costs_[n] ? 3 : -1;
+
+    if (accept < 0) {
+        phase_ = Phase::SHRINK;
+        return;
+    }
+    std::copy(&candidates[accept * n], &candidates[accept * n] + n, &vertices_[n * n]);
+    costs_[n] = cost[accept];
+    Sort();
+}
+
+bool NelderMead::Converged(double tol) const {
+    const size_t n = dim_;
+    for (size_t v = 1; v <= n; ++v)
+        for (size_t i = 0; i < n; ++i)
+            if (std::fabs(vertices_[v * n + i] - vertices_[i]) >= tol)
+                return false;
+    return phase_ != Phase::INIT;
+}
+
+ParticleSwarm::ParticleSwarm(const std::vector<double>& x0, const std::vector<double>& step0, size_t population,
+                             unsigned seed)
+    : Optimizer(x0, step0, seed), particles_(std::max<size_t>(population, 20)) {
+    const size_t n = dim_;
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    x_.resize(particles_ * n);
+    v_.resize(particles_ * n);
+    for (size_t k = 0; k < particles_; ++k) {
+        for (size_t i = 0; i < n; ++i) {
+            // The first particle starts at x0 exactly
+            x_[k * n + i] = x0[i] + (k ? step0[i] * uniform(rng_) : 0.0);
+            v_[k * n + i] = 0.5 * step0[i] * uniform(rng_);
+        }
+    }
+    pbest_ = x_;
+    pbest_cost_.assign(particles_, HUGE_VAL);
+}
+
+void ParticleSwarm::Ask(std::vector<double>& candidates) {
+    candidates = x_;
+}
+
+void ParticleSwarm::Update(const std::vector<double>& candidates, const std::vector<double>& cost) {
+    const size_t n = dim_;
+    for (size_t k = 0; k < particles_; ++k) {
+        if (cost[k] < pbest_cost_[k]) {
+            pbest_cost_[k] = cost[k];
+            std::copy(&candidates[k * n], &candidates[k * n] + n, &pbest_[k * n]);
+        }
+    }
+
+    // Constriction coefficients, chi = 0.7298 and c1 = c2 = 2.05 * chi
+    const double w = 0.7298, c = 1.49618;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const std::vector<double>& g = Best();
+    for (size_t k = 0; k < particles_; ++k) {
+        for (size_t i = 0; i < n; ++i) {
+            double& v = v_[k * n + i];
+            double& x = x_[k * n + i];
+            v = w * v + c * uniform(rng_) * (pbest_[k * n + i] - x) + c * uniform(rng_) * (g[i] - x);
+            // Keep the swarm from exploding on a flat cost surface
+            v = std::max(-2 * step0_[i], std::min(2 * step0_[i], v));
+            x += v;
+        }
+    }
+}
+
+bool ParticleSwarm::Converged(double tol) const {
+    const size_t n = dim_;
+    const std::vector<double>& g = Best();
+    for (size_t k = 0; k < particles_; ++k)
+        for (size_t i = 0; i < n; ++i)
+            if (std::fabs(x_[k * n + i] - g[i]) >= tol)
+                return false;
+    return true;
+}
+
+std::unique_ptr<Optimizer> MakeOptimizer(const std::string& method, const std::vector<double>& x0,
+                                         const std::vector<double>& step0, size_t population, unsigned seed) {
+    if (method == "cmaes")
+        return std::unique_ptr<Optimizer>(new CMAES(x0, step0, population, seed));
+    if (method == "nelder-mead")
+        return std::unique_ptr<Optimizer>(new NelderMead(x0, step0));
+    if (method == "pso")
+        return std::unique_ptr<Optimizer>(new ParticleSwarm(x0, step0, population, seed));
+    return nullptr;
+}
@@ -0,0 +1,148 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+* Derivative-free minimizer with an ask/tell interface.
+*
+* Ask() proposes a batch of candidates, the caller scores them however it
+* likes (in parallel, on the plant, ...) and hands the costs back through
+* Tell(). Candidates are flat arrays of Dim() values each.
+*/
+class Optimizer {
+public:
+  Optimizer(const std::vector<double>& x0, const std::vector<double>& step0, unsigned seed = 0);
+  virtual ~Optimizer();
+
+  virtual const char *Name() const = 0;
+
+  /*
+  * Replace candidates with the next batch to score.
+  */
+  virtual void Ask(std::vector<double>& candidates) = 0;
+
+  /*
+  * Costs of the batch returned by the last Ask(), in the same order.
+  */
+  void Tell(const std::vector<double>& candidates, const std::vector<double>& cost);
+
+  /*
+  * True once the search has contracted below tol in every coordinate.
+  */
+  virtual bool Converged(double tol) const = 0;
+
+  size_t Dim() const { return dim_; }
+  const std::vector<double>& Best() const { return best_; }
+  double BestCost() const { return best_cost_; }
+
+protected:
+  size_t dim_;
+  std::vector<double> x0_;
+  std::vector<double> step0_;
+  std::mt19937 rng_;
+
+  virtual void Update(const std::vector<double>& candidates, const std::vector<double>& cost) = 0;
+
+private:
+  std::vector<double> best_;
+  double best_cost_;
+};
+
+/*
+* (mu/mu_w, lambda) CMA-ES after Hansen's tutorial. The initial covariance is
+* diag(step0^2), so gains of very different magnitude are searched on their
+* own scale.
+*/
+class CMAES : public Optimizer {
+public:
+  CMAES(const std::vector<double>& x0, const std::vector<double>& step0, size_t population, unsigned seed);
+
+  const char *Name() const override { return "cmaes"; }
+  void Ask(std::vector<double>& candidates) override;
+  bool Converged(double tol) const override;
+
+protected:
+  void Update(const std::vector<double>& candidates, const std::vector<double>& cost) override;
+
+private:
+  size_t lambda_;
+  size_t mu_;
+  std::vector<double> weights_;
+  double mueff_, cc_, cs_, c1_, cmu_, damps_, chin_;
+
+  std::vector<double> mean_;
+  double sigma_;
+  std::vector<double> C_;   // covariance, row major
+  std::vector<double> B_;   // eigenvectors of C, columns
+  std::vector<double> D_;   // sqrt of the eigenvalues of C
+  std::vector<double> pc_;
+  std::vector<double> ps_;
+  int generation_;
+
+  void Decompose();
+};
+
+/*
+* Nelder-Mead simplex with speculative batches. Each iteration scores the
+* reflection, expansion and both contractions together and then picks the
+* move the sequential algorithm would have made; a shrink scores the Dim()
+* new vertices in one batch.
+*/
+class NelderMead : public Optimizer {
+public:
+  NelderMead(const std::vector<double>& x0, const std::vector<double>& step0);
+
+  const char *Name() const override { return "nelder-mead"; }
+  void Ask(std::vector<double>& candidates) override;
+  bool Converged(double tol) const override;
+
+protected:
+  void Update(const std::vector<double>& candidates, const std::vector<double>& cost) override;
+
+private:
+  enum class Phase {INIT, STEP, SHRINK};
+
+  Phase phase_;
+  std::vector<double> vertices_;   // Dim() + 1 vertices
+  std::vector<double> costs_;
+
+  void Sort();
+};
+
+/*
+* Global-best particle swarm with the constriction coefficients of Clerc
+* and Kennedy. Particles start uniformly within x0 +/- step0.
+*/
+class ParticleSwarm : public Optimizer {
+public:
+  ParticleSwarm(const std::vector<double>& x0, const std::vector<double>& step0, size_t population, unsigned seed);
+
+  const char *Name() const override { return "pso"; }
+  void Ask(std::vector<double>& candidates) override;
+  bool Converged(double tol) const override;
+
+protected:
+  void Update(const std::vector<double>& candidates, const std::vector<double>& cost) override;
+
+private:
+  size_t particles_;
+  std::vector<double> x_;
+  std::vector<double> v_;
+  std::vector<double> pbest_;
+  std::vector<double> pbest_cost_;
+};
+
+/*
+* Create "cmaes", "nelder-mead" or "pso", or return null for an unknown
+* method. population is a lower bound on the batch size of the population
+* methods, e.g. the number of worker threads.
+*/
+std::unique_ptr<Optimizer> MakeOptimizer(const std::string& method, const std::vector<double>& x0,
+                                         const std::vector<double>& step0, size_t population, unsigned seed);
+
+#endif /* OPTIMIZER_H */
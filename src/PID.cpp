@@ -1,4 +1,9 @@
 #include "PID.h"
+#include "GainSchedule.h"
+
+#include <cmath>
+#include <cstring>
+#include <utility>
 
 using namespace std;
 
@@ -6,7 +11,9 @@ using namespace std;
 * TODO: Complete the PID class.
 */
 
-PID::PID() {}
+PID::PID()
+    : time_base(0.0), d_filter_tau(0.0), out_min(-HUGE_VAL), out_max(HUGE_VAL),
+      anti_windup(AntiWindup::NONE), tracking_gain(1.0), schedule(nullptr) {}
 
 PID::~PID() {}
 
@@ -15,18 +22,122 @@ void PID::Init(double Kp, double Ki, double Kd) {
     this->Ki = Ki;
     this->Kd = Kd;
 
+    Reset();
+}
+
+void PID::Reset() {
     p_error = 0.0;
     i_error = 0.0;
     d_error = 0.0;
 }
 
+void PID::SetOutputLimits(double out_min, double out_max) {
+    this->out_min = out_min;
+    this->out_max = out_max;
+}
+
+void PID::SetAntiWindup(AntiWindup mode, double tracking_gain) {
+    anti_windup = mode;
+    this->tracking_gain = tracking_gain;
+}
+
+void PID::ScheduleGains(double speed) {
+    if (schedule)
+        schedule->Lookup(speed, Kp, Ki, Kd);
+}
+
 void PID::UpdateError(double cte) {
     d_error = cte - p_error;
     p_error = cte;
     i_error += cte;
+    if (anti_windup != AntiWindup::NONE)
+        LimitIntegral(cte, 1.0);
+}
+
+void PID::UpdateError(double cte, double dt) {
+    if (time_base <= 0.0) {
+        UpdateError(cte);
+        return;
+    }
+    // A missing or non-monotonic timestamp counts as one nominal step
+    if (dt <= 0.0)
+        dt = time_base;
+
+    const double scale = dt / time_base;
+    const double derivative = (cte - p_error) / scale;
+    if (d_filter_tau > 0.0) {
+        // First order low-pass, alpha = dt / (tau + dt)
+        d_error += dt / (d_filter_tau + dt) * (derivative - d_error);
+    } else {
+        d_error = derivative;
+    }
+    p_error = cte;
+    i_error += cte * scale;
+    if (anti_windup != AntiWindup::NONE)
+        LimitIntegral(cte, scale);
+}
+
+void PID::LimitIntegral(double cte, double scale) {
+    if (Ki == 0.0)
+        return;
+
+    switch (anti_windup) {
+    case AntiWindup::CLAMP: {
+        // The integral term alone may not exceed the output range
+        double lo = -out_max / Ki, hi = -out_min / Ki;
+        if (lo > hi)
+            std::swap(lo, hi);
+        i_error = fmin(fmax(i_error, lo), hi);
+        break;
+    }
+    case AntiWindup::CONDITIONAL: {
+        // Undo this step's integration if it drove the output further
+        //  into saturation
+        const double u = TotalError();
+        const double di = -Ki * cte * scale;
+        if ((u > out_max && di > 0.0) || (u < out_min && di < 0.0))
+            i_error -= cte * scale;
+        break;
+    }
+    case AntiWindup::BACK_CALCULATION: {
+        // Feed the excess output back into the integrator. Only ever bleed
+        //  the integral towards zero, so a saturating P or D kick does not
+        //  wind it up in the other direction.
+        const double u = TotalError();
+        const double excess = u - fmin(fmax(u, out_min), out_max);
+        const double next = i_error + tracking_gain * scale * excess / Ki;
+        if (next * i_error <= 0.0)
+            i_error = 0.0;
+        else if (fabs(next) < fabs(i_error))
+            i_error = next;
+        break;
+    }
+    default:
+        break;
+    }
 }
 
 double PID::TotalError() {
     return -Kp * p_error + -Ki * i_error + -Kd * d_error;
 }
 
+double PID::Output() {
+    return fmin(fmax(TotalError(), out_min), out_max);
+}
+
+bool ParseAntiWindup(const char *name, AntiWindup& mode) {
+    static const struct { const char *name; AntiWindup mode; } modes[] = {
+        {"none", AntiWindup::NONE},
+        {"clamp", AntiWindup::CLAMP},
+        {"conditional", AntiWindup::CONDITIONAL},
+        {"back-calc", AntiWindup::BACK_CALCULATION},
+    };
+    for (const auto& m : modes) {
+        if (std::strcmp(name, m.name) == 0) {
+            mode = m.mode;
+            return true;
+        }
+    }
+    return false;
+}
+
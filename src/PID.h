@@ -1,6 +1,17 @@
 #ifndef PID_H
 #define PID_H
 
+class GainSchedule;
+
+/*
+* How the integral is kept from winding up while the output saturates.
+*  CLAMP            bound the integral term to the output limits
+*  CONDITIONAL      skip integration while it would push further into saturation
+*  BACK_CALCULATION bleed off the integral by the amount the output exceeds the
+*                   limits, scaled by the tracking gain
+*/
+enum class AntiWindup {NONE, CLAMP, CONDITIONAL, BACK_CALCULATION};
+
 class PID {
 public:
   /*
@@ -17,6 +28,34 @@ public:
   double Ki;
   double Kd;
 
+  /*
+  * Time step the gains are tuned for [s]. 0 disables the time-aware update.
+  */
+  double time_base;
+
+  /*
+  * Time constant of the derivative low-pass filter [s]. 0 disables it.
+  */
+  double d_filter_tau;
+
+  /*
+  * Output limits of Output(), infinite by default.
+  */
+  double out_min;
+  double out_max;
+
+  /*
+  * Anti-windup mode and the back-calculation tracking gain, the fraction of
+  * the excess output removed from the integral per nominal step.
+  */
+  AntiWindup anti_windup;
+  double tracking_gain;
+
+  /*
+  * Speed-indexed gains, not owned. Null keeps Kp/Ki/Kd fixed.
+  */
+  const GainSchedule *schedule;
+
   /*
   * Constructor
   */
@@ -32,15 +71,61 @@ public:
   */
   void Init(double Kp, double Ki, double Kd);
 
+  /*
+  * Clear the errors and integral, keeping gains, limits and modes.
+  */
+  void Reset();
+
+  /*
+  * Set the limits the output saturates at.
+  */
+  void SetOutputLimits(double out_min, double out_max);
+
+  /*
+  * Select the anti-windup mode. Only has an effect with finite output limits.
+  */
+  void SetAntiWindup(AntiWindup mode, double tracking_gain = 1.0);
+
+  /*
+  * Load Kp/Ki/Kd for the current speed from the schedule, if any.
+  */
+  void ScheduleGains(double speed);
+
   /*
   * Update the PID error variables given cross track error.
   */
   void UpdateError(double cte);
 
+  /*
+  * Update the PID error variables given cross track error and the time dt
+  * since the previous update [s]. The derivative and integral are scaled by
+  * dt / time_base, so gains tuned per frame keep their meaning when frames
+  * arrive irregularly or the control rate changes. With dt == time_base and
+  * no filter this is exactly UpdateError(cte).
+  */
+  void UpdateError(double cte, double dt);
+
   /*
   * Calculate the total PID error.
   */
   double TotalError();
+
+  /*
+  * The total PID error saturated to [out_min, out_max].
+  */
+  double Output();
+
+private:
+  /*
+  * Apply the anti-windup mode after an integration step of cte * scale.
+  */
+  void LimitIntegral(double cte, double scale);
 };
 
+/*
+* Parse "none", "clamp", "conditional" or "back-calc". Returns false for
+* anything else.
+*/
+bool ParseAntiWindup(const char *name, AntiWindup& mode);
+
 #endif /* PID_H */
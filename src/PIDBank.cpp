@@ -0,0 +1,49 @@
+#include "PIDBank.h"
+#include "GainSchedule.h"
+#include "PIDKernels.h"
+#include <cassert>
+
+PIDBank::PIDBank() {}
+
+PIDBank::PIDBank(size_t n) {
+    Resize(n);
+}
+
+void PIDBank::Resize(size_t n) {
+    p_error.resize(n, 0.0);
+    i_error.resize(n, 0.0);
+    d_error.resize(n, 0.0);
+    Kp.resize(n, 0.0);
+    Ki.resize(n, 0.0);
+    Kd.resize(n, 0.0);
+}
+
+void PIDBank::Init(size_t i, double Kp, double Ki, double Kd) {
+    assert(i < Size());
+    this->Kp[i] = Kp;
+    this->Ki[i] = Ki;
+    this->Kd[i] = Kd;
+
+    p_error[i] = 0.0;
+    i_error[i] = 0.0;
+    d_error[i] = 0.0;
+}
+
+void PIDBank::ScheduleGainsBatch(const GainSchedule& schedule, const double* speed, size_t n) {
+    assert(n <= Size());
+    schedule.LookupBatch(speed, Kp.data(), Ki.data(), Kd.data(), n);
+}
+
+// The batch updates go through the widest SIMD kernels the CPU supports,
+// see PIDKernels.h. Every level is bit-identical to PID::UpdateError and
+// PID::TotalError.
+void PIDBank::UpdateErrorBatch(const double* cte, size_t n) {
+    assert(n <= Size());
+    GetPIDKernels().UpdateError(p_error.data(), i_error.data(), d_error.data(), cte, n);
+}
+
+void PIDBank::TotalErrorBatch(double* out, size_t n) const {
+    assert(n <= Size());
+    GetPIDKernels().TotalError(p_error.data(), i_error.data(), d_error.data(),
+                               Kp.data(), Ki.data(), Kd.data(), out, n);
+}
@@ -0,0 +1,70 @@
+#ifndef PID_BANK_H
+#define PID_BANK_H
+
+#include <cstddef>
+#include <vector>
+
+class GainSchedule;
+
+/*
+* A bank of independent PID controllers stored as structure-of-arrays.
+* Lane i of the bank behaves exactly like a separate PID object, but each
+* field lives in its own contiguous array so the batch updates stream through
+* memory and can be vectorized by the compiler.
+*/
+class PIDBank {
+public:
+  /*
+  * Errors, one entry per controller
+  */
+  std::vector<double> p_error;
+  std::vector<double> i_error;
+  std::vector<double> d_error;
+
+  /*
+  * Coefficients, one entry per controller
+  */
+  std::vector<double> Kp;
+  std::vector<double> Ki;
+  std::vector<double> Kd;
+
+  /*
+  * Constructor
+  */
+  PIDBank();
+  explicit PIDBank(size_t n);
+
+  /*
+  * Resize the bank to n controllers. New lanes start zeroed.
+  */
+  void Resize(size_t n);
+
+  /*
+  * Number of controllers in the bank.
+  */
+  size_t Size() const { return p_error.size(); }
+
+  /*
+  * Initialize the controller in lane i.
+  */
+  void Init(size_t i, double Kp, double Ki, double Kd);
+
+  /*
+  * Load the gains of lanes [0, n) from the schedule, given one speed per
+  * lane.
+  */
+  void ScheduleGainsBatch(const GainSchedule& schedule, const double* speed, size_t n);
+
+  /*
+  * Update the error variables of lanes [0, n) given one cross track error
+  * per lane.
+  */
+  void UpdateErrorBatch(const double* cte, size_t n);
+
+  /*
+  * Calculate the total PID error of lanes [0, n) into out.
+  */
+  void TotalErrorBatch(double* out, size_t n) const;
+};
+
+#endif /* PID_BANK_H */
@@ -0,0 +1,180 @@
+#include "PIDKernels.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PID_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+// Every kernel evaluates the same expressions in the same order as
+// PID::UpdateError and PID::TotalError. This file is built with
+// -ffp-contract=off so the avx512f targets (which imply FMA) don't fuse the
+// multiply-adds, keeping all levels bit-identical to the scalar PID.
+
+static void UpdateErrorScalar(double* p, double* ie, double* d, const double* cte, size_t n) {
+    for (size_t k = 0; k < n; ++k) {
+        const double c = cte[k];
+        d[k] = c - p[k];
+        p[k] = c;
+        ie[k] += c;
+    }
+}
+
+static void TotalErrorScalar(const double* p, const double* ie, const double* d,
+                             const double* kp, const double* ki, const double* kd,
+                             double* out, size_t n) {
+    for (size_t k = 0; k < n; ++k) {
+        out[k] = -kp[k] * p[k] + -ki[k] * ie[k] + -kd[k] * d[k];
+    }
+}
+
+#ifdef PID_KERNELS_X86
+
+__attribute__((target("sse2")))
+static void UpdateErrorSSE2(double* p, double* ie, double* d, const double* cte, size_t n) {
+    size_t k = 0;
+    for (; k + 2 <= n; k += 2) {
+        const __m128d c = _mm_loadu_pd(cte + k);
+        _mm_storeu_pd(d + k, _mm_sub_pd(c, _mm_loadu_pd(p + k)));
+        _mm_storeu_pd(p + k, c);
+        _mm_storeu_pd(ie + k, _mm_add_pd(_mm_loadu_pd(ie + k), c));
+    }
+    UpdateErrorScalar(p + k, ie + k, d + k, cte + k, n - k);
+}
+
+__attribute__((target("sse2")))
+static void TotalErrorSSE2(const double* p, const double* ie, const double* d,
+                           const double* kp, const double* ki, const double* kd,
+                           double* out, size_t n) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    size_t k = 0;
+    for (; k + 2 <= n; k += 2) {
+        const __m128d tp = _mm_mul_pd(_mm_xor_pd(_mm_loadu_pd(kp + k), sign), _mm_loadu_pd(p + k));
+        const __m128d ti = _mm_mul_pd(_mm_xor_pd(_mm_loadu_pd(ki + k), sign), _mm_loadu_pd(ie + k));
+        const __m128d td = _mm_mul_pd(_mm_xor_pd(_mm_loadu_pd(kd + k), sign), _mm_loadu_pd(d + k));
+        _mm_storeu_pd(out + k, _mm_add_pd(_mm_add_pd(tp, ti), td));
+    }
+    TotalErrorScalar(p + k, ie + k, d + k, kp + k, ki + k, kd + k, out + k, n - k);
+}
+
+__attribute__((target("avx2")))
+static void UpdateErrorAVX2(double* p, double* ie, double* d, const double* cte, size_t n) {
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        const __m256d c = _mm256_loadu_pd(cte + k);
+        _mm256_storeu_pd(d + k, _mm256_sub_pd(c, _mm256_loadu_pd(p + k)));
+        _mm256_storeu_pd(p + k, c);
+        _mm256_storeu_pd(ie + k, _mm256_add_pd(_mm256_loadu_pd(ie + k), c));
+    }
+    UpdateErrorSSE2(p + k, ie + k, d + k, cte + k, n - k);
+}
+
+__attribute__((target("avx2")))
+static void TotalErrorAVX2(const double* p, const double* ie, const double* d,
+                           const double* kp, const double* ki, const double* kd,
+                           double* out, size_t n) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        const __m256d tp = _mm256_mul_pd(_mm256_xor_pd(_mm256_loadu_pd(kp + k), sign), _mm256_loadu_pd(p + k));
+        const __m256d ti = _mm256_mul_pd(_mm256_xor_pd(_mm256_loadu_pd(ki + k), sign), _mm256_loadu_pd(ie + k));
+        const __m256d td = _mm256_mul_pd(_mm256_xor_pd(_mm256_loadu_pd(kd + k), sign), _mm256_loadu_pd(d + k));
+        _mm256_storeu_pd(out + k, _mm256_add_pd(_mm256_add_pd(tp, ti), td));
+    }
+    TotalErrorSSE2(p + k, ie + k, d + k, kp + k, ki + k, kd + k, out + k, n - k);
+}
+
+__attribute__((target("avx512f")))
+static void UpdateErrorAVX512(double* p, double* ie, double* d, const double* cte, size_t n) {
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        const __m512d c = _mm512_loadu_pd(cte + k);
+        _mm512_storeu_pd(d + k, _mm512_sub_pd(c, _mm512_loadu_pd(p + k)));
+        _mm512_storeu_pd(p + k, c);
+        _mm512_storeu_pd(ie + k, _mm512_add_pd(_mm512_loadu_pd(ie + k), c));
+    }
+    UpdateErrorAVX2(p + k, ie + k, d + k, cte + k, n - k);
+}
+
+__attribute__((target("avx512f")))
+static void TotalErrorAVX512(const double* p, const double* ie, const double* d,
+                             const double* kp, const double* ki, const double* kd,
+                             double* out, size_t n) {
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        // avx512f has no floating point xor, negate by subtracting from -0.0
+        const __m512d zero = _mm512_set1_pd(-0.0);
+        const __m512d tp = _mm512_mul_pd(_mm512_sub_pd(zero, _mm512_loadu_pd(kp + k)), _mm512_loadu_pd(p + k));
+        const __m512d ti = _mm512_mul_pd(_mm512_sub_pd(zero, _mm512_loadu_pd(ki + k)), _mm512_loadu_pd(ie + k));
+        const __m512d td = _mm512_mul_pd(_mm512_sub_pd(zero, _mm512_loadu_pd(kd + k)), _mm512_loadu_pd(d + k));
+        _mm512_storeu_pd(out + k, _mm512_add_pd(_mm512_add_pd(tp, ti), td));
+    }
+    TotalErrorAVX2(p + k, ie + k, d + k, kp + k, ki + k, kd + k, out + k, n - k);
+}
+
+#endif /* PID_KERNELS_X86 */
+
+SimdLevel DetectSimdLevel() {
+#ifdef PID_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SimdLevel::SSE2;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+const char* SimdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SSE2:
+        return "sse2";
+    case SimdLevel::AVX2:
+        return "avx2";
+    case SimdLevel::AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+PIDKernels GetPIDKernels(SimdLevel level) {
+    const SimdLevel detected = DetectSimdLevel();
+    if (level > detected)
+        level = detected;
+
+    switch (level) {
+#ifdef PID_KERNELS_X86
+    case SimdLevel::AVX512:
+        return PIDKernels{level, UpdateErrorAVX512, TotalErrorAVX512};
+    case SimdLevel::AVX2:
+        return PIDKernels{level, UpdateErrorAVX2, TotalErrorAVX2};
+    case SimdLevel::SSE2:
+        return PIDKernels{level, UpdateErrorSSE2, TotalErrorSSE2};
+#endif
+    default:
+        return PIDKernels{SimdLevel::SCALAR, UpdateErrorScalar, TotalErrorScalar};
+    }
+}
+
+static PIDKernels SelectPIDKernels() {
+    SimdLevel level = SimdLevel::AVX512;
+    const char* env = std::getenv("PID_SIMD");
+    if (env) {
+        if (std::strcmp(env, "scalar") == 0)
+            level = SimdLevel::SCALAR;
+        else if (std::strcmp(env, "sse2") == 0)
+            level = SimdLevel::SSE2;
+        else if (std::strcmp(env, "avx2") == 0)
+            level = SimdLevel::AVX2;
+    }
+    return GetPIDKernels(level);
+}
+
+const PIDKernels& GetPIDKernels() {
+    static const PIDKernels kernels = SelectPIDKernels();
+    return kernels;
+}
@@ -0,0 +1,55 @@
+#ifndef PID_KERNELS_H
+#define PID_KERNELS_H
+
+#include <cstddef>
+
+/*
+* Instruction set levels the batch kernels are compiled for, ordered from
+* narrowest to widest.
+*/
+enum class SimdLevel {
+  SCALAR,
+  SSE2,     // 2 controllers per instruction
+  AVX2,     // 4 controllers per instruction
+  AVX512,   // 8 controllers per instruction
+};
+
+/*
+* Kernel signatures operating on structure-of-arrays PID state (see PIDBank).
+*/
+typedef void (*UpdateErrorKernel)(double* p_error, double* i_error, double* d_error,
+                                  const double* cte, size_t n);
+typedef void (*TotalErrorKernel)(const double* p_error, const double* i_error,
+                                 const double* d_error, const double* Kp,
+                                 const double* Ki, const double* Kd,
+                                 double* out, size_t n);
+
+struct PIDKernels {
+  SimdLevel level;
+  UpdateErrorKernel UpdateError;
+  TotalErrorKernel TotalError;
+};
+
+/*
+* Widest level supported by both this build and the running CPU.
+*/
+SimdLevel DetectSimdLevel();
+
+/*
+* Human readable name of a level, e.g. "avx2".
+*/
+const char* SimdLevelName(SimdLevel level);
+
+/*
+* Kernels for the given level. Levels the CPU cannot run are lowered to the
+* widest supported one.
+*/
+PIDKernels GetPIDKernels(SimdLevel level);
+
+/*
+* Kernels picked once on first use. The PID_SIMD environment variable
+* (scalar, sse2, avx2, avx512) can cap the level for testing.
+*/
+const PIDKernels& GetPIDKernels();
+
+#endif /* PID_KERNELS_H */
@@ -0,0 +1,37 @@
+#include "Replay.h"
+#include <chrono>
+#include <cmath>
+
+ReplayStats Replay(const TraceReader& trace, Controller& controller, TraceWriter* out) {
+    ReplayStats stats = {0, 0.0, 0.0, 0.0};
+    double sum_diff = 0;
+
+    int64_t last_ns = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < trace.Blocks(); ++b) {
+        const TraceBlock& block = trace.Block(b);
+        for (size_t i = 0; i < block.rows; ++i) {
+            // Recorded frame spacing, for controllers using the time-aware update
+            const double dt = last_ns ? (block.t_ns[i] - last_ns) * 1e-9 : 0.0;
+            last_ns = block.t_ns[i];
+
+            double steer_value, throttle;
+            controller.Step(block.cte[i], block.speed[i], dt, steer_value, throttle);
+
+            const double diff = std::fabs(steer_value - block.steer[i]);
+            sum_diff += diff;
+            if (diff > stats.max_steer_diff)
+                stats.max_steer_diff = diff;
+
+            if (out)
+                out->Append(TraceFrame{block.t_ns[i], block.cte[i], block.speed[i],
+                                       block.steering_angle[i], steer_value, throttle});
+        }
+        stats.frames += block.rows;
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    stats.seconds = std::chrono::duration<double>(end - start).count();
+    stats.mean_steer_diff = stats.frames ? sum_diff / stats.frames : 0.0;
+    return stats;
+}
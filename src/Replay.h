@@ -0,0 +1,27 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstddef>
+#include "Controller.h"
+#include "Trace.h"
+
+/*
+* Summary of a replay run.
+*/
+struct ReplayStats {
+  size_t frames;
+  double seconds;
+  // Difference between the replayed and the recorded steering commands
+  double max_steer_diff;
+  double mean_steer_diff;
+};
+
+/*
+* Stream every frame of a recorded trace through controller as fast as
+* possible, open loop: the recorded cte and speed are fed in regardless of
+* what the controller commands. When out is given the resulting command
+* stream is written to it, keeping the recorded timestamps and telemetry.
+*/
+ReplayStats Replay(const TraceReader& trace, Controller& controller, TraceWriter* out);
+
+#endif /* REPLAY_H */
@@ -0,0 +1,42 @@
+#include "Simulation.h"
+#include <cmath>
+#include "Controller.h"
+
+Scenario::Scenario()
+    : track(Track::Default()), seed(0), iters(1000),
+      tParams{0.1, 0, 1.0}, throttle_mean(0.4), throttle_max(0.7),
+      anti_windup(AntiWindup::CLAMP), time_base(0.0), d_filter_tau(0.0), control_every(1),
+      schedule(nullptr) {}
+
+EpisodeResult RunEpisode(const Scenario& scenario, const double sParams[], const StopPolicy& policy) {
+    Vehicle car(scenario.track, scenario.vehicle, scenario.seed);
+    Controller ctrl;
+    ctrl.Init(sParams, scenario.tParams, scenario.throttle_mean, scenario.throttle_max);
+    ctrl.pid.SetAntiWindup(scenario.anti_windup);
+    ctrl.SetTimeBase(scenario.time_base, scenario.d_filter_tau);
+    ctrl.control_every = scenario.control_every;
+    ctrl.pid.schedule = scenario.schedule;
+
+    EpisodeResult result = {0.0, 0, false, StopReason::NONE, true};
+    double err = 0;
+    const int iters = scenario.iters;
+    const int frames = 2 * iters;
+    for (int i = 0; i < frames; ++i) {
+        const Telemetry t = car.Observe();
+        if (i > iters)
+            err += std::fabs(t.cte);
+        result.stopped = CheckStop(policy, t.cte, err);
+        if (result.stopped != StopReason::NONE)
+            break;
+
+        double steer_value, throttle;
+        ctrl.Step(t.cte, t.speed, scenario.vehicle.dt, steer_value, throttle);
+        car.Step(steer_value, throttle);
+
+        result.off_track = result.off_track || car.OffTrack();
+        ++result.frames;
+    }
+    result.exact = result.stopped == StopReason::NONE;
+    result.err = result.stopped == StopReason::CRASH ? HUGE_VAL : err / iters;
+    return result;
+}
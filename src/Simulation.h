@@ -0,0 +1,50 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "EarlyStop.h"
+#include "PID.h"
+#include "Vehicle.h"
+
+/*
+* Everything that defines one closed-loop evaluation besides the steering
+* gains.
+*/
+struct Scenario {
+  Track track;
+  VehicleParams vehicle;
+  unsigned seed;
+  // Warm up for iters frames, then score the next iters frames, as twiddle()
+  int iters;
+  double tParams[3];
+  double throttle_mean;
+  double throttle_max;
+  // Steering controller settings, as the options of the same name
+  AntiWindup anti_windup;
+  double time_base;       // 0 keeps the per-frame update
+  double d_filter_tau;
+  int control_every;
+  const GainSchedule* schedule;  // null uses the fixed gains
+
+  Scenario();
+};
+
+struct EpisodeResult {
+  double err;         // mean |cte| over the scored frames
+  int frames;         // frames simulated
+  bool off_track;     // left the track at some point
+  StopReason stopped; // why the episode ended early, if it did
+  bool exact;         // err is the full-length cost, safe to cache
+};
+
+/*
+* Drive the Controller with steering gains sParams against the plant for
+* 2 * iters frames, closed loop. Deterministic for a given scenario.
+*
+* The policy can end the episode early. A BOUND stop reports the mean over
+* iters frames so far, a lower bound of the true cost that is already worse
+* than policy.bound; a CRASH reports an infinite cost.
+*/
+EpisodeResult RunEpisode(const Scenario& scenario, const double sParams[],
+                         const StopPolicy& policy = StopPolicy());
+
+#endif /* SIMULATION_H */
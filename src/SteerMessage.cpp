@@ -0,0 +1,88 @@
+#include "SteerMessage.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static const char kEvent[] = "42[\"steer\",";
+static const char kPrefix[] = "42[\"steer\",{\"steering_angle\":";
+static const char kMiddle[] = ",\"throttle\":";
+static const char kSuffix[] = "}]";
+
+SteerMessage::SteerMessage() : len_(0) {
+    buf_[0] = '\0';
+}
+
+void SteerMessage::Format(double steer_value, double throttle) {
+    size_t pos = AppendLiteral(0, kPrefix, sizeof(kPrefix) - 1);
+    pos = AppendNumber(pos, steer_value);
+    pos = AppendLiteral(pos, kMiddle, sizeof(kMiddle) - 1);
+    pos = AppendNumber(pos, throttle);
+    pos = AppendLiteral(pos, kSuffix, sizeof(kSuffix) - 1);
+    buf_[pos] = '\0';
+    len_ = pos;
+}
+
+size_t SteerMessage::AppendLiteral(size_t pos, const char* s, size_t n) {
+    std::memcpy(buf_ + pos, s, n);
+    return pos + n;
+}
+
+// Mirrors the float serializer of json.hpp (2.1.1): "%.15g", with ".0"
+// appended to integer-looking values, a signed zero written as "0.0" or
+// "-0.0", and NaN or infinity written as null. The json serializer also
+// normalizes a locale decimal point; this program never changes the "C"
+// locale, so snprintf already emits '.'.
+// A shortest round-trip formatter would print different digits (for example
+// 0.1 + 0.2), so the wire format is kept as is.
+size_t SteerMessage::AppendNumber(size_t pos, double x) {
+    char* out = buf_ + pos;
+    if (!std::isfinite(x))
+        return AppendLiteral(pos, "null", 4);
+    if (x == 0) {
+        size_t i = 0;
+        if (std::signbit(x))
+            out[i++] = '-';
+        out[i++] = '0';
+        out[i++] = '.';
+        out[i++] = '0';
+        return pos + i;
+    }
+
+    int n = std::snprintf(out, 32, "%.15g", x);
+    bool int_like = true;
+    for (int i = 0; i < n; ++i) {
+        if (out[i] == '.' || out[i] == 'e' || out[i] == 'E') {
+            int_like = false;
+            break;
+        }
+    }
+    if (int_like) {
+        out[n++] = '.';
+        out[n++] = '0';
+    }
+    return pos + n;
+}
+
+// Finds "name": in the terminated reply and converts the number after it.
+static bool FindNumber(const char* msg, const char* name, double& value) {
+    const char* key = std::strstr(msg, name);
+    if (!key)
+        return false;
+    const char* begin = key + std::strlen(name);
+    char* stop;
+    value = std::strtod(begin, &stop);
+    return stop != begin;
+}
+
+bool ParseSteerMessage(const char* data, size_t length, double& steer_value, double& throttle) {
+    // Copied to a terminated stack buffer for strstr/strtod; replies are short
+    char msg[256];
+    if (length >= sizeof(msg) || length < sizeof(kEvent) - 1 ||
+        std::memcmp(data, kEvent, sizeof(kEvent) - 1) != 0)
+        return false;
+    std::memcpy(msg, data, length);
+    msg[length] = '\0';
+    return FindNumber(msg, "\"steering_angle\":", steer_value) &&
+           FindNumber(msg, "\"throttle\":", throttle);
+}
@@ -0,0 +1,42 @@
+#ifndef STEER_MESSAGE_H
+#define STEER_MESSAGE_H
+
+#include <cstddef>
+
+/*
+* Reusable encoder for the `42["steer",{...}]` reply sent to the simulator.
+* Formats straight into a fixed buffer owned by the object, so a reply costs
+* no heap allocation. The output is byte-for-byte what building a json object
+* with steering_angle and throttle and calling dump() produces.
+*/
+class SteerMessage {
+public:
+  SteerMessage();
+
+  /*
+  * Encode a steer command. The result stays valid until the next call.
+  */
+  void Format(double steer_value, double throttle);
+
+  /*
+  * The encoded message.
+  */
+  const char* Data() const { return buf_; }
+  size_t Length() const { return len_; }
+
+private:
+  // Prefix, two numbers of at most 32 characters each and the suffix
+  char buf_[128];
+  size_t len_;
+
+  size_t AppendNumber(size_t pos, double x);
+  size_t AppendLiteral(size_t pos, const char* s, size_t n);
+};
+
+/*
+* Decode a steer reply produced by SteerMessage (or by json dump()). Used by
+* tools that play the simulator's side of the protocol.
+*/
+bool ParseSteerMessage(const char* data, size_t length, double& steer_value, double& throttle);
+
+#endif /* STEER_MESSAGE_H */
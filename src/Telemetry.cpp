@@ -0,0 +1,218 @@
+#include "Telemetry.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// Cursor over the frame. All helpers return false once the input runs out or
+// doesn't match, so a malformed frame is reported instead of read past.
+struct Cursor {
+    const char* p;
+    const char* end;
+
+    void SkipSpace() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+            ++p;
+    }
+
+    bool Expect(char c) {
+        SkipSpace();
+        if (p == end || *p != c)
+            return false;
+        ++p;
+        return true;
+    }
+
+    bool ExpectLiteral(const char* lit, size_t len) {
+        if (static_cast<size_t>(end - p) < len || std::memcmp(p, lit, len) != 0)
+            return false;
+        p += len;
+        return true;
+    }
+
+    // Reads a JSON string and returns the span between the quotes. Escapes
+    // are skipped, not decoded; none of the fields we extract contain them.
+    bool String(const char*& begin, size_t& len) {
+        if (!Expect('"'))
+            return false;
+        begin = p;
+        for (;;) {
+            const char* q = static_cast<const char*>(std::memchr(p, '"', end - p));
+            if (!q)
+                return false;
+            // An odd number of backslashes before the quote escapes it
+            const char* b = q;
+            while (b > begin && b[-1] == '\\')
+                --b;
+            p = q + 1;
+            if (((q - b) & 1) == 0) {
+                len = q - begin;
+                return true;
+            }
+        }
+    }
+
+    // Skips any JSON value: string, object, array or bare literal/number.
+    bool SkipValue() {
+        SkipSpace();
+        if (p == end)
+            return false;
+        if (*p == '"') {
+            const char* s;
+            size_t n;
+            return String(s, n);
+        }
+        if (*p == '{' || *p == '[') {
+            int depth = 0;
+            while (p < end) {
+                const char c = *p;
+                if (c == '"') {
+                    const char* s;
+                    size_t n;
+                    if (!String(s, n))
+                        return false;
+                    continue;
+                }
+                ++p;
+                if (c == '{' || c == '[')
+                    ++depth;
+                else if ((c == '}' || c == ']') && --depth == 0)
+                    return true;
+            }
+            return false;
+        }
+        while (p < end && *p != ',' && *p != '}' && *p != ']')
+            ++p;
+        return true;
+    }
+};
+
+// Parses a number that may be quoted (the simulator sends strings) or bare.
+// The token is copied to a small stack buffer so strtod never reads past the
+// frame, and converted exactly like std::stod does. strtod also accepts
+// "nan" and "inf", which no real reading is, so those are rejected.
+bool Number(Cursor& c, double& value) {
+    c.SkipSpace();
+    const char* begin;
+    size_t len;
+    if (c.p < c.end && *c.p == '"') {
+        if (!c.String(begin, len))
+            return false;
+    } else {
+        begin = c.p;
+        if (!c.SkipValue())
+            return false;
+        len = c.p - begin;
+    }
+
+    char buf[64];
+    if (len == 0 || len >= sizeof(buf))
+        return false;
+    std::memcpy(buf, begin, len);
+    buf[len] = '\0';
+
+    char* stop;
+    value = std::strtod(buf, &stop);
+    return stop != buf && std::isfinite(value);
+}
+
+bool KeyIs(const char* key, size_t len, const char* name, size_t name_len) {
+    return len == name_len && std::memcmp(key, name, len) == 0;
+}
+
+} // namespace
+
+TelemetryStatus ParseTelemetry(const char* data, size_t length, Telemetry& out) {
+    // "42" at the start of the message means there's a websocket message event.
+    // The 4 signifies a websocket message
+    // The 2 signifies a websocket event
+    if (length <= 2 || data[0] != '4' || data[1] != '2')
+        return TelemetryStatus::NOT_EVENT;
+
+    Cursor c = {data + 2, data + length};
+
+    const char* event;
+    size_t event_len;
+    if (!c.Expect('[') || !c.String(event, event_len))
+        return TelemetryStatus::MALFORMED;
+
+    // An event without a payload, or with a null one, means manual driving
+    c.SkipSpace();
+    if (c.p < c.end && *c.p == ']')
+        return TelemetryStatus::MANUAL;
+    if (!c.Expect(','))
+        return TelemetryStatus::MALFORMED;
+    c.SkipSpace();
+    if (c.ExpectLiteral("null", 4))
+        return TelemetryStatus::MANUAL;
+
+    if (!KeyIs(event, event_len, "telemetry", 9))
+        return TelemetryStatus::OTHER_EVENT;
+
+    enum { HAVE_CTE = 1, HAVE_SPEED = 2, HAVE_ANGLE = 4, HAVE_ALL = 7 };
+    int have = 0;
+
+    if (!c.Expect('{'))
+        return TelemetryStatus::MALFORMED;
+    c.SkipSpace();
+    if (c.p < c.end && *c.p == '}')
+        return TelemetryStatus::MALFORMED;
+
+    for (;;) {
+        const char* key;
+        size_t key_len;
+        if (!c.String(key, key_len) || !c.Expect(':'))
+            return TelemetryStatus::MALFORMED;
+
+        bool ok;
+        if (KeyIs(key, key_len, "cte", 3)) {
+            ok = Number(c, out.cte);
+            have |= HAVE_CTE;
+        } else if (KeyIs(key, key_len, "speed", 5)) {
+            ok = Number(c, out.speed);
+            have |= HAVE_SPEED;
+        } else if (KeyIs(key, key_len, "steering_angle", 14)) {
+            ok = Number(c, out.steering_angle);
+            have |= HAVE_ANGLE;
+        } else {
+            ok = c.SkipValue();
+        }
+        if (!ok)
+            return TelemetryStatus::MALFORMED;
+
+        c.SkipSpace();
+        if (c.p < c.end && *c.p == ',') {
+            ++c.p;
+            continue;
+        }
+        if (!c.Expect('}') || !c.Expect(']'))
+            return TelemetryStatus::MALFORMED;
+        break;
+    }
+
+    return have == HAVE_ALL ? TelemetryStatus::OK : TelemetryStatus::MALFORMED;
+}
+
+std::string SampleImage(size_t bytes) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string image(bytes, 'A');
+    for (size_t i = 0; i < bytes; ++i)
+        image[i] = alphabet[(i * 7919) % 64];
+    return image;
+}
+
+const char* TelemetryStatusName(TelemetryStatus status) {
+    switch (status) {
+    case TelemetryStatus::OK:
+        return "ok";
+    case TelemetryStatus::MANUAL:
+        return "manual";
+    case TelemetryStatus::OTHER_EVENT:
+        return "other event";
+    case TelemetryStatus::NOT_EVENT:
+        return "not an event";
+    default:
+        return "malformed";
+    }
+}
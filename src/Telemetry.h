@@ -0,0 +1,47 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <cstddef>
+#include <string>
+
+/*
+* Fields extracted from a simulator telemetry event.
+*/
+struct Telemetry {
+  double cte;
+  double speed;
+  double steering_angle;
+};
+
+/*
+* Outcome of decoding one websocket frame.
+*/
+enum class TelemetryStatus {
+  OK,           // telemetry event, all fields decoded
+  MANUAL,       // event without data, the simulator is in manual mode
+  OTHER_EVENT,  // well formed SocketIO event that isn't telemetry
+  NOT_EVENT,    // frame isn't a "42" SocketIO message event
+  MALFORMED,    // "42" event that couldn't be decoded
+};
+
+/*
+* Decode a `42["telemetry",{...}]` frame in a single pass directly from the
+* websocket buffer. Only cte, speed and steering_angle are extracted, every
+* other member (including the camera image) is skipped without copying.
+* Never allocates. The buffer doesn't need to be null terminated. A field
+* that is NaN or infinite makes the frame MALFORMED.
+*/
+TelemetryStatus ParseTelemetry(const char* data, size_t length, Telemetry& out);
+
+/*
+* Stand-in for the simulator's base64 encoded camera image: bytes characters
+* of the base64 alphabet, for tools that build telemetry frames.
+*/
+std::string SampleImage(size_t bytes);
+
+/*
+* Short description of a status, for diagnostics.
+*/
+const char* TelemetryStatusName(TelemetryStatus status);
+
+#endif /* TELEMETRY_H */
@@ -0,0 +1,106 @@
+#include "TelemetryLog.h"
+#include <chrono>
+
+TelemetryLog::TelemetryLog()
+    : mask_(0), head_(0), tail_(0), dropped_(0), running_(false),
+      rotate_bytes_(0), segment_(0), segment_bytes_(0), file_(nullptr) {}
+
+TelemetryLog::~TelemetryLog() {
+    Close();
+}
+
+bool TelemetryLog::Open(const std::string& path, size_t rotate_bytes, size_t capacity) {
+    Close();
+
+    size_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+    ring_.assign(size, TelemetryRecord());
+    mask_ = size - 1;
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+
+    path_ = path;
+    rotate_bytes_ = rotate_bytes;
+    segment_ = 0;
+    if (!OpenSegment())
+        return false;
+
+    running_.store(true, std::memory_order_release);
+    worker_ = std::thread(&TelemetryLog::Run, this);
+    return true;
+}
+
+bool TelemetryLog::Push(const TelemetryRecord& record) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) > mask_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ring_[head & mask_] = record;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+void TelemetryLog::Close() {
+    if (!running_.exchange(false))
+        return;
+    worker_.join();
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+void TelemetryLog::Run() {
+    for (;;) {
+        // Read the flag before draining so records pushed before Close() are
+        // always written by the final pass
+        const bool running = running_.load(std::memory_order_acquire);
+
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        for (; tail != head; ++tail)
+            Write(ring_[tail & mask_]);
+        tail_.store(tail, std::memory_order_release);
+
+        if (!running)
+            break;
+        if (tail == head_.load(std::memory_order_acquire)) {
+            if (file_)
+                fflush(file_);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    if (file_)
+        fflush(file_);
+}
+
+bool TelemetryLog::OpenSegment() {
+    std::string name = path_;
+    if (segment_ > 0)
+        name += "." + std::to_string(segment_);
+    file_ = fopen(name.c_str(), "w");
+    if (!file_)
+        return false;
+    // A large stdio buffer keeps the writes to a few syscalls per second
+    setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+    segment_bytes_ = 0;
+    return true;
+}
+
+void TelemetryLog::Write(const TelemetryRecord& r) {
+    if (!file_)
+        return;
+    if (rotate_bytes_ > 0 && segment_bytes_ >= rotate_bytes_) {
+        fclose(file_);
+        ++segment_;
+        if (!OpenSegment())
+            return;
+    }
+    // %g matches the default std::ostream formatting of the old CSV
+    int n = fprintf(file_, "%d,%g,%g,%g\n", r.cnt, r.cte, r.speed, r.steering_angle);
+    if (n > 0)
+        segment_bytes_ += n;
+}
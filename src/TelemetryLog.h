@@ -0,0 +1,88 @@
+#ifndef TELEMETRY_LOG_H
+#define TELEMETRY_LOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+* One logged telemetry row.
+*/
+struct TelemetryRecord {
+  int cnt;
+  double cte;
+  double speed;
+  double steering_angle;
+};
+
+/*
+* Asynchronous `cnt,cte,speed,angle` CSV logger.
+*
+* The control thread only copies the raw record into a single-producer /
+* single-consumer ring buffer. A background thread drains the ring, formats
+* the rows and writes them out, so Push() never blocks, formats or touches
+* the file system. When the ring is full the record is dropped and counted
+* rather than stalling the control loop.
+*/
+class TelemetryLog {
+public:
+  TelemetryLog();
+  ~TelemetryLog();
+
+  /*
+  * Start logging to path. With rotate_bytes > 0 the capture is split into
+  * path, path.1, path.2, ... of at most about rotate_bytes each, otherwise a
+  * single unbounded file is written. capacity is rounded up to a power of two.
+  */
+  bool Open(const std::string& path, size_t rotate_bytes = 0, size_t capacity = 1 << 16);
+
+  /*
+  * Queue a record. Only ever call from one thread.
+  */
+  bool Push(const TelemetryRecord& record);
+
+  /*
+  * Flush everything queued so far and stop the background thread.
+  */
+  void Close();
+
+  bool IsOpen() const { return running_.load(std::memory_order_relaxed); }
+
+  /*
+  * Number of records dropped because the ring was full.
+  */
+  uint64_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+  std::vector<TelemetryRecord> ring_;
+  size_t mask_;
+
+  // Producer and consumer indices live on separate cache lines. Padding
+  // rather than alignas keeps the class safe to allocate with plain new.
+  char pad0_[64];
+  std::atomic<size_t> head_;
+  char pad1_[64 - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> tail_;
+  char pad2_[64 - sizeof(std::atomic<size_t>)];
+  std::atomic<uint64_t> dropped_;
+  char pad3_[64 - sizeof(std::atomic<uint64_t>)];
+
+  std::atomic<bool> running_;
+  std::thread worker_;
+
+  std::string path_;
+  size_t rotate_bytes_;
+  size_t segment_;
+  size_t segment_bytes_;
+  FILE* file_;
+
+  void Run();
+  bool OpenSegment();
+  void Write(const TelemetryRecord& record);
+};
+
+#endif /* TELEMETRY_LOG_H */
@@ -0,0 +1,80 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threads)
+    : fn_(nullptr), n_(0), next_(0), remaining_(0), active_(0), generation_(0), stop_(false) {
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    for (size_t i = 1; i < threads; ++i)
+        workers_.emplace_back(&ThreadPool::Worker, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& worker : workers_)
+        worker.join();
+}
+
+void ThreadPool::ParallelFor(size_t n, const std::function<void(size_t)>& fn) {
+    if (n == 0)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fn_ = &fn;
+        n_ = n;
+        next_.store(0);
+        remaining_ = n;
+        ++generation_;
+    }
+    work_cv_.notify_all();
+
+    Work(fn, n);
+
+    // Also wait for workers that joined late to leave the batch, so none of
+    // them can pick up an index of the next one
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return remaining_ == 0 && active_ == 0; });
+    fn_ = nullptr;
+}
+
+void ThreadPool::Worker() {
+    unsigned long seen = 0;
+    for (;;) {
+        const std::function<void(size_t)>* fn;
+        size_t n;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [&] { return stop_ || (fn_ && generation_ != seen); });
+            if (stop_)
+                return;
+            seen = generation_;
+            fn = fn_;
+            n = n_;
+            ++active_;
+        }
+
+        Work(*fn, n);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--active_ == 0)
+            done_cv_.notify_all();
+    }
+}
+
+void ThreadPool::Work(const std::function<void(size_t)>& fn, size_t n) {
+    for (;;) {
+        const size_t i = next_.fetch_add(1);
+        if (i >= n)
+            return;
+        fn(i);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--remaining_ == 0)
+            done_cv_.notify_all();
+    }
+}
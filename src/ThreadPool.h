@@ -0,0 +1,54 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+* Fixed set of worker threads for running batches of independent jobs, such
+* as scoring tuner candidates. The threads are created once and reused for
+* every batch.
+*/
+class ThreadPool {
+public:
+  /*
+  * threads == 0 uses one thread per hardware thread.
+  */
+  explicit ThreadPool(size_t threads = 0);
+  ~ThreadPool();
+
+  /*
+  * Number of threads working on a batch, including the caller.
+  */
+  size_t Size() const { return workers_.size() + 1; }
+
+  /*
+  * Run fn(i) for every i in [0, n) and return once all calls are done. The
+  * calling thread works on the batch too.
+  */
+  void ParallelFor(size_t n, const std::function<void(size_t)>& fn);
+
+private:
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+
+  const std::function<void(size_t)>* fn_;
+  size_t n_;
+  std::atomic<size_t> next_;
+  size_t remaining_;
+  size_t active_;
+  unsigned long generation_;
+  bool stop_;
+
+  void Worker();
+  void Work(const std::function<void(size_t)>& fn, size_t n);
+};
+
+#endif /* THREAD_POOL_H */
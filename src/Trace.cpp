@@ -0,0 +1,163 @@
+#include "Trace.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kTraceMagic[8] = {'P', 'I', 'D', 'T', 'R', 'A', 'C', 'E'};
+static const uint32_t kTraceVersion = 1;
+static const uint32_t kTraceColumns = 6;
+
+TraceWriter::TraceWriter() : file_(nullptr), block_rows_(0), rows_(0) {}
+
+TraceWriter::~TraceWriter() {
+    Close();
+}
+
+bool TraceWriter::Open(const std::string& path, size_t block_rows) {
+    Close();
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_)
+        return false;
+
+    block_rows_ = block_rows > 0 ? block_rows : 1;
+    rows_ = 0;
+    t_ns_.resize(block_rows_);
+    for (auto& column : columns_)
+        column.resize(block_rows_);
+
+    TraceHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kTraceMagic, sizeof(kTraceMagic));
+    header.version = kTraceVersion;
+    header.columns = kTraceColumns;
+    header.block_rows = static_cast<uint32_t>(block_rows_);
+    fwrite(&header, sizeof(header), 1, file_);
+    return true;
+}
+
+void TraceWriter::Append(const TraceFrame& frame) {
+    if (!file_)
+        return;
+    t_ns_[rows_] = frame.t_ns;
+    columns_[0][rows_] = frame.cte;
+    columns_[1][rows_] = frame.speed;
+    columns_[2][rows_] = frame.steering_angle;
+    columns_[3][rows_] = frame.steer;
+    columns_[4][rows_] = frame.throttle;
+    if (++rows_ == block_rows_)
+        FlushBlock();
+}
+
+void TraceWriter::Flush() {
+    if (!file_)
+        return;
+    FlushBlock();
+    fflush(file_);
+}
+
+void TraceWriter::Close() {
+    if (!file_)
+        return;
+    FlushBlock();
+    fclose(file_);
+    file_ = nullptr;
+}
+
+void TraceWriter::FlushBlock() {
+    if (rows_ == 0)
+        return;
+    const uint64_t rows = rows_;
+    fwrite(&rows, sizeof(rows), 1, file_);
+    fwrite(t_ns_.data(), sizeof(int64_t), rows_, file_);
+    for (const auto& column : columns_)
+        fwrite(column.data(), sizeof(double), rows_, file_);
+    rows_ = 0;
+}
+
+TraceReader::TraceReader() : map_(nullptr), map_size_(0), rows_(0) {}
+
+TraceReader::~TraceReader() {
+    Close();
+}
+
+bool TraceReader::Open(const std::string& path) {
+    Close();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(TraceHeader)) {
+        close(fd);
+        return false;
+    }
+    map_size_ = st.st_size;
+    map_ = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        return false;
+    }
+    madvise(map_, map_size_, MADV_SEQUENTIAL);
+
+    const char* base = static_cast<const char*>(map_);
+    TraceHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, kTraceMagic, sizeof(kTraceMagic)) != 0 ||
+        header.version != kTraceVersion || header.columns != kTraceColumns) {
+        Close();
+        return false;
+    }
+
+    size_t offset = sizeof(TraceHeader);
+    while (offset + sizeof(uint64_t) <= map_size_) {
+        uint64_t rows;
+        std::memcpy(&rows, base + offset, sizeof(rows));
+        const size_t column_bytes = rows * sizeof(double);
+        const size_t block_bytes = sizeof(uint64_t) + kTraceColumns * column_bytes;
+        if (rows == 0 || rows > header.block_rows || offset + block_bytes > map_size_)
+            break;
+
+        const char* col = base + offset + sizeof(uint64_t);
+        TraceBlock block;
+        block.rows = rows;
+        block.t_ns = reinterpret_cast<const int64_t*>(col);
+        block.cte = reinterpret_cast<const double*>(col + 1 * column_bytes);
+        block.speed = reinterpret_cast<const double*>(col + 2 * column_bytes);
+        block.steering_angle = reinterpret_cast<const double*>(col + 3 * column_bytes);
+        block.steer = reinterpret_cast<const double*>(col + 4 * column_bytes);
+        block.throttle = reinterpret_cast<const double*>(col + 5 * column_bytes);
+        blocks_.push_back(block);
+        block_start_.push_back(rows_);
+        rows_ += rows;
+        offset += block_bytes;
+    }
+    return true;
+}
+
+void TraceReader::Close() {
+    if (map_)
+        munmap(map_, map_size_);
+    map_ = nullptr;
+    map_size_ = 0;
+    rows_ = 0;
+    blocks_.clear();
+    block_start_.clear();
+}
+
+TraceFrame TraceReader::Frame(size_t row) const {
+    const size_t b = std::upper_bound(block_start_.begin(), block_start_.end(), row) - block_start_.begin() - 1;
+    const TraceBlock& block = blocks_[b];
+    const size_t i = row - block_start_[b];
+    TraceFrame frame;
+    frame.t_ns = block.t_ns[i];
+    frame.cte = block.cte[i];
+    frame.speed = block.speed[i];
+    frame.steering_angle = block.steering_angle[i];
+    frame.steer = block.steer[i];
+    frame.throttle = block.throttle[i];
+    return frame;
+}
@@ -0,0 +1,113 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+* One recorded control frame.
+*/
+struct TraceFrame {
+  int64_t t_ns;           // monotonic receive time
+  double cte;
+  double speed;
+  double steering_angle;  // as reported by the simulator
+  double steer;           // commanded steering value
+  double throttle;        // commanded throttle
+};
+
+/*
+* Column-oriented binary trace.
+*
+* The file is a 32 byte header followed by blocks of up to block_rows frames.
+* Each block is an 8 byte row count followed by one contiguous column per
+* field, in TraceFrame order, so every column of every block is 8 byte aligned
+* and can be read straight out of a memory mapping. Values are stored in host
+* byte order (little endian on every platform we run on).
+*/
+struct TraceHeader {
+  char magic[8];          // "PIDTRACE"
+  uint32_t version;
+  uint32_t columns;
+  uint32_t block_rows;
+  uint32_t reserved0;
+  uint64_t reserved1;
+};
+
+/*
+* Columns of one block in a mapped trace.
+*/
+struct TraceBlock {
+  size_t rows;
+  const int64_t* t_ns;
+  const double* cte;
+  const double* speed;
+  const double* steering_angle;
+  const double* steer;
+  const double* throttle;
+};
+
+/*
+* Buffers frames column-wise and writes a block every block_rows frames.
+*/
+class TraceWriter {
+public:
+  TraceWriter();
+  ~TraceWriter();
+
+  bool Open(const std::string& path, size_t block_rows = 4096);
+  void Append(const TraceFrame& frame);
+
+  /*
+  * Write out the pending partial block so the file is readable as is.
+  */
+  void Flush();
+  void Close();
+
+  bool IsOpen() const { return file_ != nullptr; }
+
+private:
+  FILE* file_;
+  size_t block_rows_;
+  size_t rows_;
+  std::vector<int64_t> t_ns_;
+  std::vector<double> columns_[5];
+
+  void FlushBlock();
+};
+
+/*
+* Read-only view of a trace file through a memory mapping.
+*/
+class TraceReader {
+public:
+  TraceReader();
+  ~TraceReader();
+
+  /*
+  * Map and index the file. A partially written trailing block is ignored.
+  */
+  bool Open(const std::string& path);
+  void Close();
+
+  size_t Rows() const { return rows_; }
+  size_t Blocks() const { return blocks_.size(); }
+  const TraceBlock& Block(size_t i) const { return blocks_[i]; }
+
+  /*
+  * Gather one row. Prefer iterating the blocks for bulk access.
+  */
+  TraceFrame Frame(size_t row) const;
+
+private:
+  void* map_;
+  size_t map_size_;
+  size_t rows_;
+  std::vector<TraceBlock> blocks_;
+  std::vector<size_t> block_start_;
+};
+
+#endif /* TRACE_H */
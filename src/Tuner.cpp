@@ -0,0 +1,200 @@
+#include "Tuner.h"
+#include <atomic>
+#include <chrono>
+#include "Log.h"
+
+ParallelTwiddle::ParallelTwiddle(const Scenario& scenario, ThreadPool& pool)
+    : scenario_(scenario), pool_(pool), cache_(nullptr), prune_(false), evaluations_(0), frames_(0) {}
+
+uint64_t EvaluateBatch(const Scenario& scenario, ThreadPool& pool, const double* params, double* err, size_t n,
+                       EvalCache* cache, const StopPolicy& policy) {
+    const uint64_t fingerprint = cache ? Fingerprint(scenario, policy) : 0;
+    std::vector<size_t> misses;
+    for (size_t k = 0; k < n; ++k)
+        if (!cache || !cache->Lookup(fingerprint, params + 3 * k, err[k]))
+            misses.push_back(k);
+
+    std::atomic<uint64_t> frames(0);
+    pool.ParallelFor(misses.size(), [&](size_t m) {
+        const size_t k = misses[m];
+        const EpisodeResult episode = RunEpisode(scenario, params + 3 * k, policy);
+        err[k] = episode.err;
+        frames += episode.frames;
+        // A pruned cost only bounds the real one, keep it out of the cache
+        if (cache && episode.exact)
+            cache->Insert(fingerprint, params + 3 * k, err[k]);
+    });
+    return frames;
+}
+
+void ParallelTwiddle::Evaluate(const double* params, double* err, size_t n, double bound) {
+    StopPolicy policy = policy_;
+    if (prune_)
+        policy.bound = bound * scenario_.iters;
+    frames_ += EvaluateBatch(scenario_, pool_, params, err, n, cache_, policy);
+    evaluations_ += static_cast<int>(n);
+    for (size_t k = 0; k < n; ++k)
+        history_.push_back(EvalRecord{{params[3 * k], params[3 * k + 1], params[3 * k + 2]}, err[k]});
+}
+
+void ParallelTwiddle::Checkpoint(const TuneResult& result, const double dp[], int sweeps, bool done) {
+    if (checkpoint_path_.empty())
+        return;
+    TuneCheckpoint checkpoint;
+    checkpoint.kind = TunerKind::PARALLEL_TWIDDLE;
+    checkpoint.sweeps = sweeps;
+    checkpoint.evaluations = evaluations_;
+    checkpoint.done = done;
+    for (int k = 0; k < 3; ++k) {
+        checkpoint.p[k] = checkpoint.best_p[k] = result.p[k];
+        checkpoint.dp[k] = dp[k];
+    }
+    checkpoint.best_err = result.best_err;
+    checkpoint.history = history_;
+    if (!SaveCheckpoint(checkpoint_path_, checkpoint))
+        LOG_ERROR("Failed to write checkpoint " << checkpoint_path_);
+}
+
+TuneResult ParallelTwiddle::Run(const double p0[], const double dp0[], double threshold, int max_sweeps) {
+    const auto start = std::chrono::steady_clock::now();
+    evaluations_ = 0;
+    frames_ = 0;
+    history_.clear();
+
+    TuneResult result;
+    double dp[3];
+    for (int i = 0; i < 3; ++i) {
+        result.p[i] = p0[i];
+        dp[i] = dp0[i];
+    }
+    Evaluate(result.p, &result.best_err, 1);
+    result.curve.push_back(ConvergencePoint{evaluations_, 0.0, result.best_err});
+    return Continue(result, dp, 0, threshold, max_sweeps, start);
+}
+
+TuneResult ParallelTwiddle::Resume(const TuneCheckpoint& checkpoint, double threshold, int max_sweeps) {
+    const auto start = std::chrono::steady_clock::now();
+    evaluations_ = checkpoint.evaluations;
+    frames_ = 0;
+    history_ = checkpoint.history;
+
+    TuneResult result;
+    double dp[3];
+    for (int i = 0; i < 3; ++i) {
+        result.p[i] = checkpoint.p[i];
+        dp[i] = checkpoint.dp[i];
+    }
+    result.best_err = checkpoint.best_err;
+    result.curve.push_back(ConvergencePoint{evaluations_, 0.0, result.best_err});
+    return Continue(result, dp, checkpoint.sweeps, threshold, max_sweeps, start);
+}
+
+TuneResult ParallelTwiddle::Continue(TuneResult result, double dp[], int sweep, double threshold, int max_sweeps,
+                                     std::chrono::steady_clock::time_point start) {
+    for (; sweep < max_sweeps && dp[0] + dp[1] + dp[2] > threshold; ++sweep) {
+        Checkpoint(result, dp, sweep, false);
+
+        // Probes 2i and 2i+1 are p[i] + dp[i] and p[i] - dp[i]
+        double probes[6][3];
+        double err[6];
+        for (int i = 0; i < 3; ++i) {
+            for (int k = 0; k < 3; ++k)
+                probes[2 * i][k] = probes[2 * i + 1][k] = result.p[k];
+            probes[2 * i][i] += dp[i];
+            probes[2 * i + 1][i] -= dp[i];
+        }
+        // A probe is only interesting while it can still beat best_err
+        Evaluate(&probes[0][0], err, 6, result.best_err);
+
+        double step[3] = {0, 0, 0};
+        int improved = 0;
+        int best = -1;
+        for (int i = 0; i < 3; ++i) {
+            int pick = -1;
+            if (err[2 * i] < result.best_err)
+                pick = 2 * i;
+            else if (err[2 * i + 1] < result.best_err)
+                pick = 2 * i + 1;
+
+            if (pick >= 0) {
+                step[i] = probes[pick][i] - result.p[i];
+                dp[i] *= 1.2;
+                ++improved;
+                if (best < 0 || err[pick] < err[best])
+                    best = pick;
+            } else {
+                dp[i] *= 0.8;
+            }
+        }
+        if (best < 0)
+            continue;
+
+        double next[3];
+        double next_err = err[best];
+        for (int k = 0; k < 3; ++k)
+            next[k] = probes[best][k];
+
+        if (improved > 1) {
+            double combined[3];
+            double combined_err;
+            for (int k = 0; k < 3; ++k)
+                combined[k] = result.p[k] + step[k];
+            Evaluate(combined, &combined_err, 1, next_err);
+            if (combined_err < next_err) {
+                next_err = combined_err;
+                for (int k = 0; k < 3; ++k)
+                    next[k] = combined[k];
+            }
+        }
+
+        for (int k = 0; k < 3; ++k)
+            result.p[k] = next[k];
+        result.best_err = next_err;
+        result.curve.push_back(ConvergencePoint{evaluations_,
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), result.best_err});
+        LOG_INFO("sweep " << sweep << " p=[" << result.p[0] << ", " << result.p[1] << ", " << result.p[2]
+                 << "] dp=[" << dp[0] << ", " << dp[1] << ", " << dp[2] << "] best_err: " << result.best_err);
+    }
+
+    Checkpoint(result, dp, sweep, dp[0] + dp[1] + dp[2] <= threshold);
+
+    result.sweeps = sweep;
+    result.evaluations = evaluations_;
+    result.frames = frames_;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+PopulationTuner::PopulationTuner(const Scenario& scenario, ThreadPool& pool)
+    : scenario_(scenario), pool_(pool), cache_(nullptr) {}
+
+TuneResult PopulationTuner::Run(Optimizer& optimizer, double tol, int max_evaluations) {
+    const auto start = std::chrono::steady_clock::now();
+    TuneResult result;
+    result.sweeps = 0;
+    result.evaluations = 0;
+    result.frames = 0;
+
+    std::vector<double> candidates;
+    std::vector<double> err;
+    while (result.evaluations < max_evaluations && !(result.sweeps > 0 && optimizer.Converged(tol))) {
+        optimizer.Ask(candidates);
+        const size_t n = candidates.size() / 3;
+        err.resize(n);
+        result.frames += EvaluateBatch(scenario_, pool_, candidates.data(), err.data(), n, cache_, policy_);
+        optimizer.Tell(candidates, err);
+
+        result.evaluations += static_cast<int>(n);
+        ++result.sweeps;
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.curve.push_back(ConvergencePoint{result.evaluations, seconds, optimizer.BestCost()});
+        LOG_DEBUG(optimizer.Name() << " generation " << result.sweeps << " p=[" << optimizer.Best()[0] << ", "
+                  << optimizer.Best()[1] << ", " << optimizer.Best()[2] << "] best_err: " << optimizer.BestCost());
+    }
+
+    for (int k = 0; k < 3; ++k)
+        result.p[k] = optimizer.Best()[k];
+    result.best_err = optimizer.BestCost();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,138 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Checkpoint.h"
+#include "EvalCache.h"
+#include "Optimizer.h"
+#include "Simulation.h"
+#include "ThreadPool.h"
+
+/*
+* Best error found after a number of evaluations.
+*/
+struct ConvergencePoint {
+  int evaluations;
+  double seconds;
+  double best_err;
+};
+
+/*
+* Outcome of a tuning run.
+*/
+struct TuneResult {
+  double p[3];
+  double best_err;
+  int sweeps;         // sweeps or generations
+  int evaluations;
+  uint64_t frames;    // plant frames simulated
+  double seconds;
+  std::vector<ConvergencePoint> curve;
+};
+
+/*
+* Score n gain vectors (3 doubles each) on the plant in parallel. With a
+* cache, known gains are answered from it and only the rest are simulated;
+* only full, unpruned costs are added to it. Returns the frames simulated.
+*/
+uint64_t EvaluateBatch(const Scenario& scenario, ThreadPool& pool, const double* params, double* err, size_t n,
+                       EvalCache* cache = nullptr, const StopPolicy& policy = StopPolicy());
+
+/*
+* Twiddle over the in-process plant, scoring all perturbations of a sweep at
+* once.
+*
+* The serial twiddle() tries p[i] + dp[i], then p[i] - dp[i], one gain after
+* the other, each on a live simulator run. Here every sweep scores the six
+* probes p +/- dp[i] e_i concurrently on independent plant instances. Each
+* gain keeps twiddle's step rule (dp grows by 1.2 when either probe beat the
+* best error, shrinks by 0.8 otherwise), and p moves to the best improving
+* probe, or to the combination of all improving probes when that scores
+* better still.
+*/
+class ParallelTwiddle {
+public:
+  ParallelTwiddle(const Scenario& scenario, ThreadPool& pool);
+
+  /*
+  * Tune from p with initial steps dp until sum(dp) <= threshold or
+  * max_sweeps sweeps have run.
+  */
+  TuneResult Run(const double p[], const double dp[], double threshold, int max_sweeps);
+
+  /*
+  * Continue a run from a PARALLEL_TWIDDLE checkpoint.
+  */
+  TuneResult Resume(const TuneCheckpoint& checkpoint, double threshold, int max_sweeps);
+
+  /*
+  * Write a checkpoint with the evaluation history to path after every
+  * sweep. Empty disables checkpoints.
+  */
+  void SetCheckpoint(const std::string& path) { checkpoint_path_ = path; }
+
+  /*
+  * Consult and fill cache before simulating, see EvaluateBatch.
+  */
+  void SetCache(EvalCache* cache) { cache_ = cache; }
+
+  /*
+  * Stop probes as soon as they can no longer beat the best error (exact:
+  * the tuning result doesn't change), and stop episodes whose |cte| exceeds
+  * crash_cte (0 disables).
+  */
+  void SetEarlyStop(bool prune, double crash_cte) {
+    prune_ = prune;
+    policy_.crash_cte = crash_cte;
+  }
+
+private:
+  const Scenario& scenario_;
+  ThreadPool& pool_;
+  EvalCache* cache_;
+  bool prune_;
+  StopPolicy policy_;
+  int evaluations_;
+  uint64_t frames_;
+  std::string checkpoint_path_;
+  std::vector<EvalRecord> history_;
+
+  void Evaluate(const double* params, double* err, size_t n, double bound = HUGE_VAL);
+  TuneResult Continue(TuneResult result, double dp[], int sweep, double threshold, int max_sweeps,
+                      std::chrono::steady_clock::time_point start);
+  void Checkpoint(const TuneResult& result, const double dp[], int sweeps, bool done);
+};
+
+/*
+* Drives any Optimizer over the in-process plant: every batch the optimizer
+* asks for is scored concurrently on the pool.
+*/
+class PopulationTuner {
+public:
+  PopulationTuner(const Scenario& scenario, ThreadPool& pool);
+
+  /*
+  * Run until the optimizer has converged to within tol or max_evaluations
+  * episodes have been scored.
+  */
+  TuneResult Run(Optimizer& optimizer, double tol, int max_evaluations);
+
+  void SetCache(EvalCache* cache) { cache_ = cache; }
+
+  /*
+  * Stop episodes whose |cte| exceeds crash_cte (0 disables).
+  */
+  void SetEarlyStop(double crash_cte) { policy_.crash_cte = crash_cte; }
+
+private:
+  const Scenario& scenario_;
+  ThreadPool& pool_;
+  EvalCache* cache_;
+  StopPolicy policy_;
+};
+
+#endif /* TUNER_H */
@@ -0,0 +1,100 @@
+#include "Vehicle.h"
+#include <cmath>
+
+static const double kMphPerMps = 2.23694;
+static const double kPi = 3.14159265358979323846;
+
+Track::Track() : half_width(4.0) {}
+
+Track Track::Default() {
+    Track t;
+    // Bends are given as {arc length, 1 / radius}
+    t.segments = {
+        {250, 0.0},
+        {kPi / 2 * 80, 1.0 / 80},
+        {120, 0.0},
+        {kPi / 3 * 60, -1.0 / 60},
+        {kPi / 3 * 60, 1.0 / 60},
+        {200, 0.0},
+        {kPi / 2 * 50, 1.0 / 50},
+        {100, 0.0},
+        {kPi * 2 / 3 * 70, 1.0 / 70},
+        {150, 0.0},
+        {kPi / 3 * 70, 1.0 / 70},
+    };
+    return t;
+}
+
+double Track::Length() const {
+    double length = 0;
+    for (const auto& seg : segments)
+        length += seg.length;
+    return length;
+}
+
+double Track::Curvature(double s) const {
+    const double length = Length();
+    if (length <= 0)
+        return 0;
+    s = std::fmod(s, length);
+    if (s < 0)
+        s += length;
+    for (const auto& seg : segments) {
+        if (s < seg.length)
+            return seg.curvature;
+        s -= seg.length;
+    }
+    return segments.back().curvature;
+}
+
+VehicleParams::VehicleParams()
+    : Lf(2.67), max_steer(25.0 * kPi / 180.0), max_accel(10.0),
+      // 40% throttle settles just under 50 mph, like the simulator
+      drag(4.0 / (22.0 * 22.0)), dt(0.05), cte_noise(0.0) {}
+
+Vehicle::Vehicle(const Track& track, const VehicleParams& params, unsigned seed)
+    : track_(track), params_(params), seed_(seed), noise_(0.0, 1.0) {
+    Reset();
+}
+
+void Vehicle::Reset() {
+    rng_.seed(seed_);
+    noise_.reset();
+    s_ = 0;
+    d_ = 0;
+    psi_ = 0;
+    v_ = 0;
+    delta_ = 0;
+}
+
+void Vehicle::Step(double steer_value, double throttle) {
+    const double dt = params_.dt;
+    delta_ = steer_value * params_.max_steer;
+
+    const double k = track_.Curvature(s_);
+    const double s_dot = v_ * std::cos(psi_) / (1.0 - k * d_);
+    const double d_dot = v_ * std::sin(psi_);
+    const double psi_dot = v_ / params_.Lf * delta_ - k * s_dot;
+    const double v_dot = params_.max_accel * throttle - params_.drag * v_ * v_;
+
+    s_ += s_dot * dt;
+    d_ += d_dot * dt;
+    psi_ += psi_dot * dt;
+    v_ += v_dot * dt;
+    if (v_ < 0)
+        v_ = 0;
+}
+
+Telemetry Vehicle::Observe() {
+    Telemetry t;
+    t.cte = d_;
+    if (params_.cte_noise > 0)
+        t.cte += params_.cte_noise * noise_(rng_);
+    t.speed = v_ * kMphPerMps;
+    t.steering_angle = delta_ * 180.0 / kPi;
+    return t;
+}
+
+bool Vehicle::OffTrack() const {
+    return std::fabs(d_) > track_.half_width;
+}
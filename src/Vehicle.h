@@ -0,0 +1,100 @@
+#ifndef VEHICLE_H
+#define VEHICLE_H
+
+#include <random>
+#include <vector>
+#include "Telemetry.h"
+
+/*
+* A track is a closed sequence of constant curvature segments. Positive
+* curvature turns right, matching the sign of the simulator's steering.
+*/
+struct TrackSegment {
+  double length;     // [m]
+  double curvature;  // [1/m]
+};
+
+class Track {
+public:
+  std::vector<TrackSegment> segments;
+  double half_width;  // distance from the center line to the edge [m]
+
+  Track();
+
+  /*
+  * A loop of straights and left/right bends roughly the size of the
+  * simulator's lake track.
+  */
+  static Track Default();
+
+  double Length() const;
+
+  /*
+  * Curvature at arc length s, wrapping around the loop.
+  */
+  double Curvature(double s) const;
+};
+
+/*
+* Vehicle and integration parameters of the plant.
+*/
+struct VehicleParams {
+  double Lf;          // distance from the front axle to the center of gravity [m]
+  double max_steer;   // steering angle for a steer value of 1 [rad]
+  double max_accel;   // acceleration at full throttle [m/s^2]
+  double drag;        // quadratic drag coefficient [1/m]
+  double dt;          // time between telemetry frames [s]
+  double cte_noise;   // standard deviation of the measured cte [m]
+
+  VehicleParams();
+};
+
+/*
+* Kinematic bicycle model driving along a Track, written in path coordinates:
+* arc length s, lateral offset d (the cross track error, positive to the right
+* of the center line), heading error psi and speed v. It stands in for the
+* simulator by turning the steer/throttle commands into the next telemetry
+* frame.
+*/
+class Vehicle {
+public:
+  Vehicle(const Track& track, const VehicleParams& params, unsigned seed = 0);
+
+  /*
+  * Put the car back on the center line at rest, like the "reset" event.
+  */
+  void Reset();
+
+  /*
+  * Apply one steer value in [-1, 1] and throttle for one frame.
+  */
+  void Step(double steer_value, double throttle);
+
+  /*
+  * What the simulator would report: cte [m], speed [mph] and steering
+  * angle [deg].
+  */
+  Telemetry Observe();
+
+  bool OffTrack() const;
+
+  double s() const { return s_; }
+  double d() const { return d_; }
+  double psi() const { return psi_; }
+  double v() const { return v_; }
+
+private:
+  const Track& track_;
+  VehicleParams params_;
+  unsigned seed_;
+  std::mt19937 rng_;
+  std::normal_distribution<double> noise_;
+
+  double s_;
+  double d_;
+  double psi_;
+  double v_;
+  double delta_;
+};
+
+#endif /* VEHICLE_H */
@@ -0,0 +1,330 @@
+// Microbenchmarks for the per-frame hot path: PID updates, telemetry
+// decoding and steer message encoding. Reports ns/op and heap
+// allocations/op.
+//
+//   ./pid_bench [--frames <file>] [--check]
+//
+// --frames reads captured websocket frames, one per line, instead of the
+// built-in sample frame. --check only verifies that the fast encoders match
+// the json.hpp code they replace and exits non-zero if they don't.
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "BasicPID.h"
+#include "GainSchedule.h"
+#include "PID.h"
+#include "PIDBank.h"
+#include "PIDKernels.h"
+#include "SteerMessage.h"
+#include "Telemetry.h"
+
+using json = nlohmann::json;
+
+static std::atomic<uint64_t> allocations(0);
+
+// Count every heap allocation. GCC flags the malloc/free pairing below once
+// it inlines these replacements, which is exactly what they are meant to do.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+// Keeps results alive so the optimizer can't drop the measured work
+static volatile double sink;
+
+// Run body(iterations) with growing iteration counts until it takes at least
+// 200 ms, then print the time and allocations per op. ops_per_iter is the
+// number of ops one iteration stands for.
+template <typename Body>
+static void run(const char *name, size_t ops_per_iter, Body body)
+{
+    size_t iters = 1;
+    for (;;)
+    {
+        const uint64_t allocs_before = allocations.load();
+        const auto start = std::chrono::steady_clock::now();
+        body(iters);
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        const uint64_t allocs = allocations.load() - allocs_before;
+        if (ns >= 2e8 || iters >= (size_t(1) << 40))
+        {
+            const double ops = static_cast<double>(iters) * ops_per_iter;
+            std::printf("%-36s %12.2f ns/op %10.2f allocs/op\n", name, ns / ops, allocs / ops);
+            return;
+        }
+        iters *= ns < 1e6 ? 10 : 2;
+    }
+}
+
+// The telemetry decoding used by main.cpp before ParseTelemetry, kept here as
+// the baseline.
+static std::string hasData(std::string s)
+{
+    auto found_null = s.find("null");
+    auto b1 = s.find_first_of("[");
+    auto b2 = s.find_last_of("]");
+    if (found_null != std::string::npos)
+        return "";
+    else if (b1 != std::string::npos && b2 != std::string::npos)
+        return s.substr(b1, b2 - b1 + 1);
+    return "";
+}
+
+static double parseWithJson(const char *data, size_t length)
+{
+    auto s = hasData(std::string(data).substr(0, length));
+    if (s == "")
+        return 0;
+    auto j = json::parse(s);
+    std::string event = j[0].get<std::string>();
+    if (event != "telemetry")
+        return 0;
+    double cte = std::stod(j[1]["cte"].get<std::string>());
+    double speed = std::stod(j[1]["speed"].get<std::string>());
+    double angle = std::stod(j[1]["steering_angle"].get<std::string>());
+    return cte + speed + angle;
+}
+
+// A telemetry frame shaped like the simulator's, with a base64 camera image
+// of typical size
+static std::string sampleFrame()
+{
+    const std::string image = SampleImage(16 * 1024);
+    return "42[\"telemetry\",{\"cte\":\"0.7598\",\"speed\":\"0.4380\",\"steering_angle\":\"0.0000\","
+           "\"throttle\":\"0.0000\",\"image\":\"" + image + "\"}]";
+}
+
+static void benchPID()
+{
+    const size_t n = 4096;
+    std::vector<double> cte(n);
+    for (size_t i = 0; i < n; ++i)
+        cte[i] = std::sin(i * 0.01);
+
+    std::vector<PID> pids(n);
+    for (auto &pid : pids)
+        pid.Init(0.15, 0.0, 3.31);
+    run("PID::UpdateError+TotalError", n, [&](size_t iters) {
+        double acc = 0;
+        for (size_t it = 0; it < iters; ++it)
+            for (size_t i = 0; i < n; ++i)
+            {
+                pids[i].UpdateError(cte[i]);
+                acc += pids[i].TotalError();
+            }
+        sink = acc;
+    });
+
+    GainSchedule schedule;
+    schedule.Parse("30:0.2,0,3.6;40:0.15,0,3.31;50:0.1,0,3.0");
+    std::vector<double> speed(n);
+    for (size_t i = 0; i < n; ++i)
+        speed[i] = 25 + 30 * std::fabs(std::sin(i * 0.37));
+    for (auto &pid : pids)
+        pid.schedule = &schedule;
+    run("PID scheduled gains", n, [&](size_t iters) {
+        double acc = 0;
+        for (size_t it = 0; it < iters; ++it)
+            for (size_t i = 0; i < n; ++i)
+            {
+                pids[i].ScheduleGains(speed[i]);
+                pids[i].UpdateError(cte[i]);
+                acc += pids[i].TotalError();
+            }
+        sink = acc;
+    });
+
+    std::vector<BasicPID<float>> float_pids(n);
+    for (auto &pid : float_pids)
+        pid.Init(0.15f, 0.0f, 3.31f);
+    run("BasicPID<float>", n, [&](size_t iters) {
+        float acc = 0;
+        for (size_t it = 0; it < iters; ++it)
+            for (size_t i = 0; i < n; ++i)
+            {
+                float_pids[i].UpdateError(static_cast<float>(cte[i]));
+                acc += float_pids[i].TotalError();
+            }
+        sink = acc;
+    });
+
+    std::vector<StaticPID<double, TunedSteerGains>> static_pids(n);
+    run("StaticPID<double, TunedSteerGains>", n, [&](size_t iters) {
+        double acc = 0;
+        for (size_t it = 0; it < iters; ++it)
+            for (size_t i = 0; i < n; ++i)
+            {
+                static_pids[i].UpdateError(cte[i]);
+                acc += static_pids[i].TotalError();
+            }
+        sink = acc;
+    });
+
+    PIDBank bank(n);
+    for (size_t i = 0; i < n; ++i)
+        bank.Init(i, 0.15, 0.0, 3.31);
+    std::vector<double> out(n);
+    const SimdLevel levels[] = {SimdLevel::SCALAR, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512};
+    for (SimdLevel level : levels)
+    {
+        const PIDKernels kernels = GetPIDKernels(level);
+        if (kernels.level != level)
+            continue;
+        const std::string name = std::string("PIDBank batch (") + SimdLevelName(level) + ")";
+        run(name.c_str(), n, [&](size_t iters) {
+            for (size_t it = 0; it < iters; ++it)
+            {
+                kernels.UpdateError(bank.p_error.data(), bank.i_error.data(), bank.d_error.data(), cte.data(), n);
+                kernels.TotalError(bank.p_error.data(), bank.i_error.data(), bank.d_error.data(),
+                                   bank.Kp.data(), bank.Ki.data(), bank.Kd.data(), out.data(), n);
+            }
+            sink = out[0];
+        });
+    }
+
+    run("PIDBank::ScheduleGainsBatch", n, [&](size_t iters) {
+        for (size_t it = 0; it < iters; ++it)
+            bank.ScheduleGainsBatch(schedule, speed.data(), n);
+        sink = bank.Kp[0];
+    });
+}
+
+static void benchParse(const std::vector<std::string> &frames)
+{
+    run("hasData + json::parse + stod", frames.size(), [&](size_t iters) {
+        double acc = 0;
+        for (size_t it = 0; it < iters; ++it)
+            for (const auto &f : frames)
+                acc += parseWithJson(f.data(), f.size());
+        sink = acc;
+    });
+
+    run("ParseTelemetry", frames.size(), [&](size_t iters) {
+        double acc = 0;
+        for (size_t it = 0; it < iters; ++it)
+            for (const auto &f : frames)
+            {
+                Telemetry t;
+                if (ParseTelemetry(f.data(), f.size(), t) == TelemetryStatus::OK)
+                    acc += t.cte + t.speed + t.steering_angle;
+            }
+        sink = acc;
+    });
+}
+
+// SteerMessage has to produce exactly what json dump() does, including the
+//  corner cases of its float serializer
+static bool checkEncode()
+{
+    const double values[] = {-0.123456789, 0.4, 0.1 + 0.2, 1.0, -1.0, 0.0, -0.0, 1e-20, 123456789012345678.0,
+                             NAN, INFINITY, -INFINITY};
+    SteerMessage reply;
+    bool ok = true;
+    for (double steer : values)
+    {
+        json msgJson;
+        msgJson["steering_angle"] = steer;
+        msgJson["throttle"] = 0.4;
+        const std::string expected = "42[\"steer\"," + msgJson.dump() + "]";
+        reply.Format(steer, 0.4);
+        if (expected != std::string(reply.Data(), reply.Length()))
+        {
+            std::printf("SteerMessage mismatch: %s, json dump: %s\n", reply.Data(), expected.c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static void benchEncode()
+{
+    run("json dump steer message", 1, [&](size_t iters) {
+        size_t acc = 0;
+        for (size_t it = 0; it < iters; ++it)
+        {
+            json msgJson;
+            msgJson["steering_angle"] = -0.123456789 + it * 1e-9;
+            msgJson["throttle"] = 0.4;
+            auto msg = "42[\"steer\"," + msgJson.dump() + "]";
+            acc += msg.length();
+        }
+        sink = acc;
+    });
+
+    SteerMessage reply;
+    run("SteerMessage::Format", 1, [&](size_t iters) {
+        size_t acc = 0;
+        for (size_t it = 0; it < iters; ++it)
+        {
+            reply.Format(-0.123456789 + it * 1e-9, 0.4);
+            acc += reply.Length();
+        }
+        sink = acc;
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> frames;
+    bool check_only = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            std::ifstream in(argv[++i]);
+            std::string line;
+            while (std::getline(in, line))
+                if (!line.empty())
+                    frames.push_back(line);
+            if (frames.empty())
+            {
+                std::fprintf(stderr, "No frames in %s\n", argv[i]);
+                return -1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--check") == 0)
+            check_only = true;
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--frames <file>] [--check]\n", argv[0]);
+            return -1;
+        }
+    }
+    if (!checkEncode())
+        return 1;
+    if (check_only)
+        return 0;
+    if (frames.empty())
+        frames.push_back(sampleFrame());
+
+    std::printf("SIMD level: %s, %zu telemetry frame(s)\n", SimdLevelName(GetPIDKernels().level), frames.size());
+    benchPID();
+    benchParse(frames);
+    benchEncode();
+    return 0;
+}
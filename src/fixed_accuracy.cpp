@@ -0,0 +1,142 @@
+// Accuracy of the fixed-point PID against the double PID.
+//
+// The double controller drives the vehicle model closed loop; every
+// fixed-point format sees the same cte stream, open loop, and its clamped
+// steering output is compared with the double one. Each format then also
+// drives the vehicle on its own, closed loop, to show the effect on
+// tracking.
+//
+//   ./pid_fixed_accuracy [--frames 20000] [--gains 0.15 0 3.31]
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "FixedPoint.h"
+#include "PID.h"
+#include "Vehicle.h"
+
+struct Comparison
+{
+    double max_error = 0;
+    double sum_sq_error = 0;
+    int frames = 0;
+};
+
+// Steering from the double PID, clamped like test() does
+static double steerDouble(PID &pid, double cte)
+{
+    pid.UpdateError(cte);
+    return ClampOutput(pid.TotalError(), -1.0, 1.0);
+}
+
+template <typename T>
+static double steerFixed(BasicPID<T> &pid, double cte)
+{
+    pid.UpdateError(T(cte));
+    return ClampOutput(pid.TotalError(), T(-1.0), T(1.0)).ToDouble();
+}
+
+// Open loop: the fixed controller follows the double controller's cte stream
+template <typename T>
+static Comparison compare(const double gains[], int frames)
+{
+    Track track = Track::Default();
+    VehicleParams params;
+    Vehicle car(track, params);
+    PID reference;
+    reference.Init(gains[0], gains[1], gains[2]);
+    BasicPID<T> fixed;
+    fixed.Init(T(gains[0]), T(gains[1]), T(gains[2]));
+
+    Comparison c;
+    for (int i = 0; i < frames; ++i)
+    {
+        const Telemetry t = car.Observe();
+        const double expected = steerDouble(reference, t.cte);
+        const double actual = steerFixed(fixed, t.cte);
+        const double error = std::fabs(actual - expected);
+        c.max_error = std::fmax(c.max_error, error);
+        c.sum_sq_error += error * error;
+        ++c.frames;
+        car.Step(expected, 0.4);
+    }
+    return c;
+}
+
+// Closed loop: mean |cte| when T drives the vehicle
+template <typename T>
+static double track(const double gains[], int frames)
+{
+    Track track = Track::Default();
+    VehicleParams params;
+    Vehicle car(track, params);
+    BasicPID<T> pid;
+    pid.Init(T(gains[0]), T(gains[1]), T(gains[2]));
+
+    double sum = 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        const Telemetry t = car.Observe();
+        sum += std::fabs(t.cte);
+        car.Step(steerFixed(pid, t.cte), 0.4);
+    }
+    return sum / frames;
+}
+
+static double trackDouble(const double gains[], int frames)
+{
+    Track track = Track::Default();
+    VehicleParams params;
+    Vehicle car(track, params);
+    PID pid;
+    pid.Init(gains[0], gains[1], gains[2]);
+
+    double sum = 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        const Telemetry t = car.Observe();
+        sum += std::fabs(t.cte);
+        car.Step(steerDouble(pid, t.cte), 0.4);
+    }
+    return sum / frames;
+}
+
+template <typename T>
+static void report(const char *name, const double gains[], int frames)
+{
+    const Comparison c = compare<T>(gains, frames);
+    std::printf("%-22s %14.3e %14.3e %14.5f\n", name, c.max_error,
+                std::sqrt(c.sum_sq_error / c.frames), track<T>(gains, frames));
+}
+
+int main(int argc, char *argv[])
+{
+    int frames = 20000;
+    double gains[3] = {0.15, 0.0, 3.31};
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--gains") == 0 && i + 3 < argc)
+        {
+            for (int k = 0; k < 3; ++k)
+                gains[k] = std::atof(argv[++i]);
+        }
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--frames <n>] [--gains <Kp> <Ki> <Kd>]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    std::printf("gains [%g, %g, %g], %d frames\n", gains[0], gains[1], gains[2], frames);
+    std::printf("%-22s %14s %14s %14s\n", "format", "max |error|", "rms error", "mean |cte|");
+    std::printf("%-22s %14s %14s %14.5f\n", "double", "-", "-", trackDouble(gains, frames));
+    report<Fixed<24> >("Q7.24 (int32)", gains, frames);
+    report<Fixed<20> >("Q11.20 (int32)", gains, frames);
+    report<Fixed<16> >("Q15.16 (int32)", gains, frames);
+    report<Fixed<12> >("Q19.12 (int32)", gains, frames);
+    report<Fixed<11, int16_t, int32_t> >("Q4.11 (int16)", gains, frames);
+    report<Fixed<8, int16_t, int32_t> >("Q7.8 (int16)", gains, frames);
+    return 0;
+}
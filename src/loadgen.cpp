@@ -0,0 +1,197 @@
+// Load generator that plays the simulator's side of the protocol. It opens
+// many websocket connections to the pid server, sends
+// 42["telemetry",{...}] frames at a fixed rate on each one and measures the
+// round trip time to the 42["steer",...] reply.
+//
+// Every connection drives its own Vehicle model with the steer and throttle
+// it gets back, so the server sees realistic closed-loop telemetry.
+//
+//   ./pid_loadgen [--url ws://localhost:4567] [--connections 100]
+//                 [--rate 20] [--duration 10] [--image-bytes 16384]
+#include <uWS/uWS.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Histogram.h"
+#include "Log.h"
+#include "SteerMessage.h"
+#include "Telemetry.h"
+#include "Vehicle.h"
+
+// Monotonic timestamp in nanoseconds
+// One simulated simulator
+struct Client
+{
+    int id;
+    uWS::WebSocket<uWS::CLIENT> *ws = nullptr;
+    Vehicle car;
+    int64_t sent_ns = 0;
+    bool waiting = false;
+    std::string frame;
+
+    Client(int id, const Track &track, const VehicleParams &params)
+        : id(id), car(track, params, id) {}
+};
+
+struct LoadGen
+{
+    std::string url = "ws://localhost:4567";
+    int connections = 100;
+    double rate = 20;
+    double duration = 10;
+    size_t image_bytes = 16 * 1024;
+
+    Track track = Track::Default();
+    VehicleParams params;
+    std::vector<Client *> clients;
+    std::string image;
+
+    int connected = 0;
+    int failed = 0;
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    uint64_t skipped = 0;
+    int64_t start_ns = 0;
+    unsigned long tick = 0;
+    unsigned long period_ticks = 1;
+    LatencyHistogram rtt;
+};
+
+// Build the telemetry frame from the vehicle state, like the simulator does
+static void formatFrame(LoadGen &gen, Client &client)
+{
+    const Telemetry t = client.car.Observe();
+    char numbers[160];
+    std::snprintf(numbers, sizeof(numbers),
+                  "42[\"telemetry\",{\"cte\":\"%.4f\",\"speed\":\"%.4f\",\"steering_angle\":\"%.4f\","
+                  "\"throttle\":\"%.4f\",\"image\":\"",
+                  t.cte, t.speed, t.steering_angle, 0.0);
+    client.frame.assign(numbers);
+    client.frame += gen.image;
+    client.frame += "\"}]";
+}
+
+// Runs every millisecond. Each connection sends on its own slot of the period
+//  so the frames are spread evenly instead of arriving in bursts.
+static void onTick(uS::Timer *timer)
+{
+    LoadGen &gen = *static_cast<LoadGen *>(timer->getData());
+    const unsigned long slot = gen.tick++ % gen.period_ticks;
+
+    for (Client *client : gen.clients)
+    {
+        if (!client->ws || static_cast<unsigned long>(client->id) % gen.period_ticks != slot)
+            continue;
+        if (client->waiting)
+        {
+            // The server hasn't answered the previous frame yet
+            ++gen.skipped;
+            continue;
+        }
+        formatFrame(gen, *client);
+        client->sent_ns = NowNs();
+        client->waiting = true;
+        client->ws->send(client->frame.data(), client->frame.size(), uWS::OpCode::TEXT);
+        ++gen.sent;
+    }
+
+    if (NowNs() - gen.start_ns >= static_cast<int64_t>(gen.duration * 1e9))
+    {
+        const double seconds = (NowNs() - gen.start_ns) / 1e9;
+        LOG_RESULT(gen.connected << " connections (" << gen.failed << " failed), "
+                   << gen.sent << " frames sent, " << gen.received << " replies, "
+                   << gen.skipped << " frames skipped waiting for a reply\n"
+                   << "Throughput: " << gen.received / seconds << " replies/s\n"
+                   << "Round trip: " << gen.rtt.Summary());
+        std::exit(0);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    InitLogging();
+
+    LoadGen gen;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--url") == 0 && i + 1 < argc)
+            gen.url = argv[++i];
+        else if (std::strcmp(argv[i], "--connections") == 0 && i + 1 < argc)
+            gen.connections = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+            gen.rate = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--duration") == 0 && i + 1 < argc)
+            gen.duration = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--image-bytes") == 0 && i + 1 < argc)
+            gen.image_bytes = std::strtoul(argv[++i], nullptr, 10);
+        else
+        {
+            LOG_ERROR("usage: " << argv[0] << " [--url <ws url>] [--connections <n>] [--rate <frames/s>]"
+                      << " [--duration <s>] [--image-bytes <n>]");
+            return -1;
+        }
+    }
+    if (gen.rate <= 0 || gen.connections <= 0)
+    {
+        LOG_ERROR("--rate and --connections must be positive");
+        return -1;
+    }
+
+    gen.image = SampleImage(gen.image_bytes);
+
+    // The vehicle advances by one telemetry period per reply
+    gen.params.dt = 1.0 / gen.rate;
+    gen.period_ticks = std::max(1UL, static_cast<unsigned long>(1000.0 / gen.rate));
+
+    uWS::Hub h;
+
+    h.onConnection([&gen](uWS::WebSocket<uWS::CLIENT> ws, uWS::HttpRequest req) {
+        Client *client = static_cast<Client *>(ws.getData());
+        client->ws = new uWS::WebSocket<uWS::CLIENT>(ws);
+        ++gen.connected;
+    });
+
+    h.onError([&gen](void *user) {
+        ++gen.failed;
+        LOG_ERROR("Connection " << static_cast<Client *>(user)->id << " failed");
+    });
+
+    h.onMessage([&gen](uWS::WebSocket<uWS::CLIENT> ws, char *data, size_t length, uWS::OpCode opCode) {
+        Client *client = static_cast<Client *>(ws.getData());
+        double steer_value, throttle;
+        if (!client->waiting || !ParseSteerMessage(data, length, steer_value, throttle))
+            return;
+        gen.rtt.Record(NowNs() - client->sent_ns);
+        client->waiting = false;
+        client->car.Step(steer_value, throttle);
+        if (client->car.OffTrack())
+            client->car.Reset();
+        ++gen.received;
+    });
+
+    h.onDisconnection([&gen](uWS::WebSocket<uWS::CLIENT> ws, int code, char *message, size_t length) {
+        Client *client = static_cast<Client *>(ws.getData());
+        delete client->ws;
+        client->ws = nullptr;
+        --gen.connected;
+    });
+
+    for (int i = 0; i < gen.connections; ++i)
+    {
+        Client *client = new Client(i, gen.track, gen.params);
+        gen.clients.push_back(client);
+        h.connect(gen.url, client);
+    }
+
+    gen.start_ns = NowNs();
+    uS::Timer *timer = new uS::Timer(h.getLoop());
+    timer->setData(&gen);
+    timer->start(onTick, 1, 1);
+
+    LOG_INFO("Opening " << gen.connections << " connections to " << gen.url << " at " << gen.rate
+             << " frames/s each for " << gen.duration << " s");
+    h.run();
+}
@@ -1,122 +1,404 @@
 #include <uWS/uWS.h>
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
-#include "json.hpp"
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "Checkpoint.h"
+#include "Controller.h"
+#include "EarlyStop.h"
+#include "EvalCache.h"
+#include "GainSchedule.h"
+#include "Histogram.h"
+#include "Log.h"
+#include "Metrics.h"
 #include "PID.h"
+#include "Replay.h"
+#include "Simulation.h"
+#include "SteerMessage.h"
+#include "Telemetry.h"
+#include "TelemetryLog.h"
+#include "Trace.h"
+#include "Tuner.h"
 #include <math.h>
 
-// for convenience
-using json = nlohmann::json;
-
 // For converting back and forth between radians and degrees.
 constexpr double pi() { return M_PI; }
 double deg2rad(double x) { return x * pi() / 180; }
 double rad2deg(double x) { return x * 180 / pi(); }
 
-// Checks if the SocketIO event has JSON data.
-// If there is data the JSON object in string format will be returned,
-// else the empty string "" will be returned.
-std::string hasData(std::string s)
+double max_speed_u = 50;
+double max_speed_l = 48;
+double throttleMean = 0.4;
+double throttleMax = 0.7;
+// Anti-windup of the steering PID, see AntiWindup
+AntiWindup antiWindup = AntiWindup::CLAMP;
+// Speed-indexed steering gains, empty uses the fixed sParams
+GainSchedule gainSchedule;
+// Early termination of tuning runs, see EarlyStop.h
+bool earlyStop = false;
+double crashCte = 0;
+// Split the telemetry log into files of this many bytes, 0 keeps one file
+size_t logRotateBytes = 0;
+// Per-frame debug messages are printed once every this many frames
+unsigned long logSampleEvery = 50;
+
+double handleMessage(uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length, uWS::OpCode opCode, PID &pid, double &throttle, SteerMessage &reply)
 {
-    auto found_null = s.find("null");
-    auto b1 = s.find_first_of("[");
-    auto b2 = s.find_last_of("]");
-    if (found_null != std::string::npos)
+    Telemetry t;
+    switch (ParseTelemetry(data, length, t))
+    {
+    case TelemetryStatus::OK:
     {
-        return "";
+        double cte = t.cte;
+        double speed = t.speed;
+        double steer_value;
+        /*
+         * TODO: Calcuate steering value here, remember the steering value is
+         * [-1, 1].
+         * NOTE: Feel free to play around with the throttle and speed. Maybe use
+         * another PID controller to control the speed!
+        */
+        pid.UpdateError(cte);
+        steer_value = pid.Output();
+
+        if (throttle >= throttleMean && speed >= max_speed_u)
+            throttle -= 0.1;
+        else if (throttle <= throttleMean && speed < max_speed_l)
+            throttle += 0.1;
+
+        // DEBUG
+        LOG_DEBUG_EVERY_N(logSampleEvery, "CTE: " << cte << " Steering Value: " << steer_value);
+
+        reply.Format(steer_value, throttle);
+        //std::cout << reply.Data() << std::endl;
+        ws.send(reply.Data(), reply.Length(), uWS::OpCode::TEXT);
+
+        return cte;
     }
-    else if (b1 != std::string::npos && b2 != std::string::npos)
+    case TelemetryStatus::MANUAL:
     {
-        return s.substr(b1, b2 - b1 + 1);
+        // Manual driving
+        std::string msg = "42[\"manual\",{}]";
+        ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
+        return 0;
+    }
+    case TelemetryStatus::MALFORMED:
+        LOG_ERROR("Dropping malformed telemetry frame");
+        return 0;
+    default:
+        return 0;
     }
-    return "";
 }
 
-double max_speed_u = 50;
-double max_speed_l = 48;
-double throttleMean = 0.4;
-double throttleMax = 0.7;
+struct Session;
+struct InfoPackage;
 
-double handleMessage(uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length, uWS::OpCode opCode, PID &pid, double &throttle)
-{
-    // "42" at the start of the message means there's a websocket message event.
-    // The 4 signifies a websocket message
-    // The 2 signifies a websocket event
-    if (length && length > 2 && data[0] == '4' && data[1] == '2')
+// Shared by all hubs: the startup handshake and the /stats report
+struct HubGroup {
+    std::vector<InfoPackage *> packs;
+    std::mutex mutex;
+    std::condition_variable ready;
+    int reported = 0;
+    bool failed = false;
+
+    // Report whether this hub listens and wait for the others. Returns false
+    //  if any hub failed, so either every hub serves or none does.
+    bool WaitForAll(bool listening)
     {
-        auto s = hasData(std::string(data).substr(0, length));
-        if (s != "")
-        {
-            auto j = json::parse(s);
-            std::string event = j[0].get<std::string>();
-            if (event == "telemetry")
-            {
-                // j[1] is the data JSON object
-                double cte = std::stod(j[1]["cte"].get<std::string>());
-                double speed = std::stod(j[1]["speed"].get<std::string>());
-                double angle = std::stod(j[1]["steering_angle"].get<std::string>());
-                double steer_value;
-                /*
-                 * TODO: Calcuate steering value here, remember the steering value is
-                 * [-1, 1].
-                 * NOTE: Feel free to play around with the throttle and speed. Maybe use
-                 * another PID controller to control the speed!
-                */
-                pid.UpdateError(cte);
-                steer_value = pid.TotalError();
-                if (steer_value < -1)
-                    steer_value = -1;
-                else if (steer_value > 1)
-                    steer_value = 1;
-
-                if (throttle >= throttleMean && speed >= max_speed_u)
-                    throttle -= 0.1;
-                else if (throttle <= throttleMean && speed < max_speed_l)
-                    throttle += 0.1;
-
-                // DEBUG
-                std::cout << "CTE: " << cte << " Steering Value: " << steer_value << std::endl;
-
-                json msgJson;
-                msgJson["steering_angle"] = steer_value;
-                msgJson["throttle"] = throttle;
-                auto msg = "42[\"steer\"," + msgJson.dump() + "]";
-                //std::cout << msg << std::endl;
-                ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
-
-                return cte;
-            }
-        }
-        else
-        {
-            // Manual driving
-            std::string msg = "42[\"manual\",{}]";
-            ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
-            return 0;
-        }
+        std::unique_lock<std::mutex> lock(mutex);
+        failed = failed || !listening;
+        ++reported;
+        ready.notify_all();
+        ready.wait(lock, [this]() { return reported == static_cast<int>(packs.size()); });
+        return !failed;
     }
-}
+};
 
+// State of one event loop (hub). With several hubs each one has its own
+//  package, so nothing here is shared between threads except the session ids.
 struct InfoPackage {
+    TelemetryLog log;
+    // Each session records to trace_path, trace_path.1, trace_path.2, ...
+    std::string trace_path;
+    // Session ids are unique across all hubs
+    std::atomic<int> *sessions = nullptr;
+    HubGroup *group = nullptr;
+    int hub = 0;
+    int listen_options = 0;
+    // Controller timing, see Controller::SetTimeBase and control_every
+    double time_base = 0;
+    double d_filter_tau = 0;
+    int control_every = 1;
+    // Sessions connected to this hub, for the /stats report. Any hub may
+    //  serve /stats, so stats_mutex guards the set and the sessions' latency
+    //  and metrics.
+    std::unordered_set<Session *> live;
+    std::mutex stats_mutex;
+};
+
+// Stages of the telemetry callback that are timed separately
+enum FrameStage
+{
+    STAGE_PARSE,
+    STAGE_CONTROL,
+    STAGE_LOG,
+    STAGE_SEND,
+    STAGE_TOTAL,
+    STAGE_COUNT,
+};
+
+const char *stageNames[STAGE_COUNT] = {"parse", "control", "log", "send", "total"};
+
+// Controller state of one connected simulator. Created when the simulator
+//  connects and stored in the websocket's user data.
+struct Session {
+    int id;
     int cnt = 0;
-    double cte,speed,steering_angle;
-    std::ofstream outfile;
+    int64_t last_ns = 0;
+    Controller ctrl;
+    SteerMessage reply;
+    TraceWriter trace;
+    LatencyHistogram latency[STAGE_COUNT];
+    DriveMetrics metrics;
 };
 
+// Per stage latency percentiles of a session
+std::string sessionReport(const Session &session)
+{
+    std::string report = "Session " + std::to_string(session.id) + " metrics: " + session.metrics.Summary() + "\n";
+    for (int k = 0; k < STAGE_COUNT; ++k)
+    {
+        report += "Session " + std::to_string(session.id) + " " + stageNames[k] + ": ";
+        report += session.latency[k].Summary() + "\n";
+    }
+    return report;
+}
+
 int test(double sParams[], double tParams[], InfoPackage& info);
-int twiddle();
+int twiddle(const char *checkpoint_path, bool resume, const char *cache_path, uint64_t settings);
+int replay(const char *trace_path, const char *out_path, double sParams[], double tParams[],
+           double time_base, double d_filter_tau, int control_every);
+int simulate(int frames, const char *trace_path, double sParams[], double tParams[],
+             double time_base, double d_filter_tau, int control_every);
+int tune(const char *method, int threads, int max_evals, const char *curve_path,
+         const char *checkpoint_path, bool resume, const char *cache_path,
+         double time_base, double d_filter_tau, int control_every);
+
+// Fingerprint of the options that change how a twiddle() run drives or is
+//  scored, so the evaluation cache never hands back costs of another setup
+static uint64_t twiddleSettingsFingerprint()
+{
+    Fingerprinter fp;
+    fp.Add(static_cast<int>(antiWindup));
+    fp.Add(throttleMean);
+    fp.Add(max_speed_u);
+    fp.Add(max_speed_l);
+    fp.Add(crashCte);
+    return fp.Value();
+}
+
+// Load the evaluation cache at path, if any. A missing file is fine.
+static bool loadCache(EvalCache &cache, const char *path)
+{
+    if (!path)
+        return true;
+    if (!cache.Load(path))
+    {
+        LOG_ERROR("Corrupt evaluation cache " << path);
+        return false;
+    }
+    LOG_INFO("Loaded " << cache.Size() << " cached evaluations from " << path);
+    return true;
+}
 
-int main()
+// Monotonic timestamp in nanoseconds
+int main(int argc, char *argv[])
 {
-    //return twiddle();
+    InitLogging();
 
-    InfoPackage pack;
-    pack.outfile.open("temp.txt", std::ios::out);
     double sParams[3] = {0.15, 0.0, 3.31};        // {0.2, 0, 3.31};
     double tParams[3] = {0.1, 0, 1.0};
     std::vector<double> cte_history;
 
-    int res = test(sParams, tParams, pack);
+    const char *trace_path = nullptr;
+    const char *replay_path = nullptr;
+    const char *out_path = nullptr;
+    int sim_frames = 0;
+    const char *tune_method = nullptr;
+    const char *curve_path = nullptr;
+    int max_evals = 20000;
+    bool run_twiddle = false;
+    const char *checkpoint_path = nullptr;
+    bool resume = false;
+    const char *cache_path = nullptr;
+    int threads = 0;
+    int hubs = 1;
+    double time_base = 0;
+    double d_filter_tau = 0;
+    int control_every = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        // --trace <file> records every frame to a binary trace, see Trace.h
+        if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            trace_path = argv[++i];
+        // --replay <file> drives the controller from a recorded trace
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replay_path = argv[++i];
+        // --out <file> writes the replayed command stream
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            out_path = argv[++i];
+        // --sim <frames> drives the built-in vehicle model instead of the simulator
+        else if (std::strcmp(argv[i], "--sim") == 0 && i + 1 < argc)
+            sim_frames = std::atoi(argv[++i]);
+        // --tune [twiddle|cmaes|nelder-mead|pso] tunes the steering gains
+        //  against the vehicle model, twiddle by default
+        else if (std::strcmp(argv[i], "--tune") == 0)
+            tune_method = i + 1 < argc && argv[i + 1][0] != '-' ? argv[++i] : "twiddle";
+        // --twiddle runs the original twiddle against the live simulator
+        else if (std::strcmp(argv[i], "--twiddle") == 0)
+            run_twiddle = true;
+        // --checkpoint <file> saves the twiddle state there as it goes
+        else if (std::strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+            checkpoint_path = argv[++i];
+        // --resume continues from the --checkpoint file
+        else if (std::strcmp(argv[i], "--resume") == 0)
+            resume = true;
+        // --cache <file> memoizes episode costs across tuning runs
+        else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+            cache_path = argv[++i];
+        // --early-stop ends twiddle runs once they can't beat the best error
+        else if (std::strcmp(argv[i], "--early-stop") == 0)
+            earlyStop = true;
+        // --crash-cte <m> ends tuning runs once |cte| exceeds m
+        else if (std::strcmp(argv[i], "--crash-cte") == 0 && i + 1 < argc)
+            crashCte = std::atof(argv[++i]);
+        // --evals <n> caps the number of episodes a tuner may score
+        else if (std::strcmp(argv[i], "--evals") == 0 && i + 1 < argc)
+            max_evals = std::atoi(argv[++i]);
+        // --curve <file> writes the tuner's best error per generation as CSV
+        else if (std::strcmp(argv[i], "--curve") == 0 && i + 1 < argc)
+            curve_path = argv[++i];
+        // --threads <n> limits the tuner's worker threads, 0 uses all cores
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = std::atoi(argv[++i]);
+        // --hubs <n> serves connections from n event loop threads
+        else if (std::strcmp(argv[i], "--hubs") == 0 && i + 1 < argc)
+            hubs = std::max(1, std::atoi(argv[++i]));
+        // --log-rotate <bytes> splits each telemetry log into files of about
+        //  this size
+        else if (std::strcmp(argv[i], "--log-rotate") == 0 && i + 1 < argc)
+            logRotateBytes = std::strtoull(argv[++i], nullptr, 10);
+        // --time-base <s> switches to the time-aware PID update, with gains
+        //  tuned for frames this many seconds apart
+        else if (std::strcmp(argv[i], "--time-base") == 0 && i + 1 < argc)
+            time_base = std::atof(argv[++i]);
+        // --derivative-filter <s> low-pass filters the derivative term
+        else if (std::strcmp(argv[i], "--derivative-filter") == 0 && i + 1 < argc)
+            d_filter_tau = std::atof(argv[++i]);
+        // --control-every <n> only updates the controllers every n frames
+        else if (std::strcmp(argv[i], "--control-every") == 0 && i + 1 < argc)
+            control_every = std::max(1, std::atoi(argv[++i]));
+        // --anti-windup <none|clamp|conditional|back-calc> selects how the
+        //  steering integral is limited while the output saturates
+        else if (std::strcmp(argv[i], "--anti-windup") == 0 && i + 1 < argc)
+        {
+            if (!ParseAntiWindup(argv[++i], antiWindup))
+            {
+                LOG_ERROR("Unknown anti-windup mode " << argv[i]);
+                return -1;
+            }
+        }
+        // --schedule "<speed>:<Kp>,<Ki>,<Kd>;..." interpolates the steering
+        //  gains by speed
+        else if (std::strcmp(argv[i], "--schedule") == 0 && i + 1 < argc)
+        {
+            if (!gainSchedule.Parse(argv[++i]))
+            {
+                LOG_ERROR("Malformed gain schedule " << argv[i]);
+                return -1;
+            }
+        }
+        // --gains <Kp> <Ki> <Kd> overrides the steering parameters
+        else if (std::strcmp(argv[i], "--gains") == 0 && i + 3 < argc)
+        {
+            for (int k = 0; k < 3; ++k)
+                sParams[k] = std::atof(argv[++i]);
+        }
+        else
+        {
+            LOG_ERROR("Unknown or incomplete option " << argv[i]);
+            return -1;
+        }
+    }
+
+    if (control_every > 1 && time_base <= 0)
+        LOG_ERROR("--control-every without --time-base changes the effective gains");
+
+    if (replay_path)
+        return replay(replay_path, out_path, sParams, tParams, time_base, d_filter_tau, control_every);
+    if (sim_frames > 0)
+        return simulate(sim_frames, trace_path, sParams, tParams, time_base, d_filter_tau, control_every);
+    if (resume && !checkpoint_path)
+    {
+        LOG_ERROR("--resume needs --checkpoint <file>");
+        return -1;
+    }
+    if (run_twiddle)
+    {
+        // twiddle() drives a bare PID frame by frame, without timing or schedule
+        if (time_base > 0 || d_filter_tau > 0 || control_every > 1)
+        {
+            LOG_ERROR("--twiddle doesn't support --time-base, --derivative-filter or --control-every");
+            return -1;
+        }
+        if (!gainSchedule.Empty())
+            LOG_INFO("Ignoring --schedule while tuning the fixed gains");
+        return twiddle(checkpoint_path, resume, cache_path, twiddleSettingsFingerprint());
+    }
+    if (tune_method)
+        return tune(tune_method, threads, max_evals, curve_path, checkpoint_path, resume, cache_path,
+                    time_base, d_filter_tau, control_every);
+
+    std::atomic<int> sessions(0);
+    HubGroup group;
+    std::vector<std::unique_ptr<InfoPackage>> packs;
+    for (int k = 0; k < hubs; ++k)
+    {
+        InfoPackage *pack = new InfoPackage;
+        packs.emplace_back(pack);
+        group.packs.push_back(pack);
+        pack->sessions = &sessions;
+        pack->group = &group;
+        pack->hub = k;
+        // Let the kernel spread incoming connections over all hubs
+        pack->listen_options = hubs > 1 ? uS::ListenOptions::REUSE_PORT : 0;
+        std::string log_path = k == 0 ? "temp.txt" : "temp." + std::to_string(k) + ".txt";
+        if (!pack->log.Open(log_path, logRotateBytes))
+            LOG_ERROR("Failed to open telemetry log " << log_path);
+        if (trace_path)
+            pack->trace_path = trace_path;
+        pack->time_base = time_base;
+        pack->d_filter_tau = d_filter_tau;
+        pack->control_every = control_every;
+    }
+
+    // Hub 0 runs on the main thread, every other one on its own thread
+    std::vector<std::thread> loops;
+    for (int k = 1; k < hubs; ++k)
+        loops.emplace_back([&packs, k, &sParams, &tParams]() {
+            test(sParams, tParams, *packs[k]);
+        });
+    int res = test(sParams, tParams, *packs[0]);
+    for (auto &loop : loops)
+        loop.join();
 
     //for (const auto &e : cte_history) outFile << e << "\n";
     return res;
@@ -129,99 +411,89 @@ int main()
 int test(double sParams[], double tParams[], InfoPackage& pack)
 {
     uWS::Hub h;
-    double throttle = throttleMean;
 
-    PID pid;
-    PID throttle_pid;
-    // TODO: Initialize the pid variable.
-    std::cout << "Initing PIDs\n";
-    pid.Init(sParams[0], sParams[1], sParams[2]);
-    throttle_pid.Init(tParams[0], tParams[1], tParams[2]);
-
-    h.onMessage([&pid, &throttle, &throttle_pid, &pack](uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length, uWS::OpCode opCode) {
-        // "42" at the start of the message means there's a websocket message event.
-        // The 4 signifies a websocket message
-        // The 2 signifies a websocket event
+    h.onMessage([&pack](uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length, uWS::OpCode opCode) {
+        Session *session = static_cast<Session *>(ws.getData());
+        if (!session)
+            return;
+
         //std::cout << std::string(data).substr(0, length) << std::endl;
-        if (length && length > 2 && data[0] == '4' && data[1] == '2')
+        const int64_t t_ns = NowNs();
+        Telemetry t;
+        TelemetryStatus status = ParseTelemetry(data, length, t);
+        if (status == TelemetryStatus::OK)
         {
-            auto s = hasData(std::string(data).substr(0, length));
-            if (s != "")
-            {
-                auto j = json::parse(s);
-                std::string event = j[0].get<std::string>();
-                //std::cout << "j: " << j << std::endl;
-                if (event == "telemetry")
-                {
-                    // j[1] is the data JSON object
-                    double cte = std::stod(j[1]["cte"].get<std::string>());
-                    double speed = std::stod(j[1]["speed"].get<std::string>());
-                    double angle = std::stod(j[1]["steering_angle"].get<std::string>());
-                    double steer_value;
-                    /*
-                     * TODO: Calcuate steering value here, remember the steering value is
-                     * [-1, 1].
-                     * NOTE: Feel free to play around with the throttle and speed. Maybe use
-                     * another PID controller to control the speed!
-                    */
-                    std::cout << "Updating pid\n";
-                    pid.UpdateError(cte);
-                    steer_value = pid.TotalError();
-                    // Constrain the steering angle
-                    if (steer_value < -1)
-                        steer_value = -1;
-                    else if (steer_value > 1)
-                        steer_value = 1;
-
-                    // Update and get throttle value. It is contrained to be around
-                    //  the value of throttle we want
-                    throttle_pid.UpdateError(cte);
-                    throttle = throttleMean;// - throttle_pid.TotalError();
-
-                    // Don't let throttle get beyond a certain maximum
-                    if (throttle >= throttleMax)
-                        throttle = throttleMax;
-
-                    // DEBUG
-                    pack.cnt++;
-                    if (pack.cnt < 1250)
-                    {
-                        pack.cte = cte;
-                        pack.speed = speed;
-                        pack.steering_angle = angle;
-                        pack.outfile << pack.cnt << "," << cte << "," << speed << "," << angle << "\n";
-                    }
-                    else if (pack.outfile.is_open() && pack.cnt >= 1250)
-                    {
-                        pack.outfile.close();
-                    }
-                    std::cout << "CTE: " << cte << " Steering Value: " << steer_value << " cnt: " << pack.cnt << std::endl;
-                    //cte_history.push_back(cte);
-                    //outfile << cte << "\n";
-                    //outfile.flush();
-
-                    json msgJson;
-                    msgJson["steering_angle"] = steer_value;
-                    msgJson["throttle"] = throttle;
-                    auto msg = "42[\"steer\"," + msgJson.dump() + "]";
-                    std::cout << msg << std::endl;
-                    ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
-                }
-            }
-            else
-            {
-                // Manual driving
-                std::string msg = "42[\"manual\",{}]";
-                ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
-            }
+            const int64_t t_parsed = NowNs();
+            double cte = t.cte;
+            double speed = t.speed;
+            double angle = t.steering_angle;
+            double steer_value;
+            double throttle;
+            /*
+             * TODO: Calcuate steering value here, remember the steering value is
+             * [-1, 1].
+             * NOTE: Feel free to play around with the throttle and speed. Maybe use
+             * another PID controller to control the speed!
+            */
+            LOG_DEBUG_EVERY_N(logSampleEvery, "Updating pid");
+            const double dt = session->last_ns ? (t_ns - session->last_ns) * 1e-9 : 0.0;
+            session->last_ns = t_ns;
+            session->ctrl.Step(cte, speed, dt, steer_value, throttle);
+            const int64_t t_control = NowNs();
+
+            // DEBUG
+            session->cnt++;
+            pack.log.Push(TelemetryRecord{session->cnt, cte, speed, angle});
+            if (session->trace.IsOpen())
+                session->trace.Append(TraceFrame{t_ns, cte, speed, angle, steer_value, throttle});
+            LOG_DEBUG_EVERY_N(logSampleEvery, "Session " << session->id << " CTE: " << cte
+                              << " Steering Value: " << steer_value << " cnt: " << session->cnt);
+            //cte_history.push_back(cte);
+            //outfile << cte << "\n";
+            //outfile.flush();
+            const int64_t t_logged = NowNs();
+
+            session->reply.Format(steer_value, throttle);
+            LOG_DEBUG_EVERY_N(logSampleEvery, session->reply.Data());
+            ws.send(session->reply.Data(), session->reply.Length(), uWS::OpCode::TEXT);
+            const int64_t t_sent = NowNs();
+
+            std::lock_guard<std::mutex> lock(pack.stats_mutex);
+            session->metrics.Add(cte, speed, steer_value);
+            session->latency[STAGE_PARSE].Record(t_parsed - t_ns);
+            session->latency[STAGE_CONTROL].Record(t_control - t_parsed);
+            session->latency[STAGE_LOG].Record(t_logged - t_control);
+            session->latency[STAGE_SEND].Record(t_sent - t_logged);
+            session->latency[STAGE_TOTAL].Record(t_sent - t_ns);
+        }
+        else if (status == TelemetryStatus::MANUAL)
+        {
+            // Manual driving
+            std::string msg = "42[\"manual\",{}]";
+            ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
+        }
+        else if (status == TelemetryStatus::MALFORMED)
+        {
+            LOG_ERROR("Dropping malformed telemetry frame");
         }
     });
 
-    // We don't need this since we're not using HTTP but if it's removed the program
-    // doesn't compile :-(
-    h.onHttpRequest([](uWS::HttpResponse *res, uWS::HttpRequest req, char *data, size_t, size_t) {
+    // GET /stats returns the latency report of every session on every hub
+    h.onHttpRequest([&pack](uWS::HttpResponse *res, uWS::HttpRequest req, char *data, size_t, size_t) {
         const std::string s = "<h1>Hello world!</h1>";
-        if (req.getUrl().valueLength == 1)
+        const std::string url(req.getUrl().value, req.getUrl().valueLength);
+        if (url == "/stats")
+        {
+            std::string report;
+            for (InfoPackage *hub : pack.group->packs)
+            {
+                std::lock_guard<std::mutex> lock(hub->stats_mutex);
+                for (const Session *session : hub->live)
+                    report += sessionReport(*session);
+            }
+            res->end(report.data(), report.length());
+        }
+        else if (req.getUrl().valueLength == 1)
         {
             res->end(s.data(), s.length());
         }
@@ -232,33 +504,266 @@ int test(double sParams[], double tParams[], InfoPackage& pack)
         }
     });
 
-    h.onConnection([&h](uWS::WebSocket<uWS::SERVER> ws, uWS::HttpRequest req) {
-        std::cout << "Connected!!!" << std::endl;
+    h.onConnection([&pack, sParams, tParams](uWS::WebSocket<uWS::SERVER> ws, uWS::HttpRequest req) {
+        Session *session = new Session;
+        session->id = (*pack.sessions)++;
+        // TODO: Initialize the pid variable.
+        LOG_INFO("Initing PIDs");
+        session->ctrl.Init(sParams, tParams, throttleMean, throttleMax);
+        session->ctrl.pid.SetAntiWindup(antiWindup);
+        if (!gainSchedule.Empty())
+            session->ctrl.pid.schedule = &gainSchedule;
+        session->ctrl.SetTimeBase(pack.time_base, pack.d_filter_tau);
+        session->ctrl.control_every = pack.control_every;
+        if (!pack.trace_path.empty())
+        {
+            std::string path = pack.trace_path;
+            if (session->id > 0)
+                path += "." + std::to_string(session->id);
+            if (!session->trace.Open(path))
+                LOG_ERROR("Failed to open trace " << path);
+        }
+        ws.setData(session);
+        {
+            std::lock_guard<std::mutex> lock(pack.stats_mutex);
+            pack.live.insert(session);
+        }
+        LOG_INFO("Connected!!! Session " << session->id << " on hub " << pack.hub);
     });
 
-    h.onDisconnection([&h](uWS::WebSocket<uWS::SERVER> ws, int code, char *message, size_t length) {
+    h.onDisconnection([&pack](uWS::WebSocket<uWS::SERVER> ws, int code, char *message, size_t length) {
+        Session *session = static_cast<Session *>(ws.getData());
+        ws.setData(nullptr);
         ws.close();
-        std::cout << "Disconnected" << std::endl;
+        if (session)
+        {
+            std::lock_guard<std::mutex> lock(pack.stats_mutex);
+            LOG_INFO("Disconnected Session " << session->id << " on hub " << pack.hub << " after " << session->cnt << " frames\n"
+                     << sessionReport(*session));
+            pack.live.erase(session);
+            delete session;
+        }
+        if (pack.log.Dropped())
+            LOG_ERROR("Telemetry log dropped " << pack.log.Dropped() << " rows");
     });
 
     int port = 4567;
-    if (h.listen(port))
+    const bool listening = h.listen(port, nullptr, pack.listen_options);
+    if (listening)
     {
-        std::cout << "Listening to port " << port << std::endl;
+        LOG_INFO("Listening to port " << port << " on hub " << pack.hub);
     }
     else
     {
-        std::cerr << "Failed to listen to port" << std::endl;
-        return -1;
+        LOG_ERROR("Failed to listen to port " << port << " on hub " << pack.hub);
     }
+    // Only serve once every hub listens, so a failed hub fails the server
+    if (!pack.group->WaitForAll(listening))
+        return -1;
     h.run();
+    return 0;
+}
+
+/** Replay a recorded trace through the controller, without the simulator
+ * @param trace_path  The recorded trace
+ * @param out_path    Where to write the replayed commands, may be null
+ * @param time_base, d_filter_tau, control_every  Controller timing, see Controller
+ */
+int replay(const char *trace_path, const char *out_path, double sParams[], double tParams[],
+           double time_base, double d_filter_tau, int control_every)
+{
+    TraceReader trace;
+    if (!trace.Open(trace_path))
+    {
+        LOG_ERROR("Failed to open trace " << trace_path);
+        return -1;
+    }
+
+    TraceWriter out;
+    if (out_path && !out.Open(out_path))
+    {
+        LOG_ERROR("Failed to open " << out_path);
+        return -1;
+    }
+
+    Controller ctrl;
+    ctrl.Init(sParams, tParams, throttleMean, throttleMax);
+    ctrl.pid.SetAntiWindup(antiWindup);
+    if (!gainSchedule.Empty())
+        ctrl.pid.schedule = &gainSchedule;
+    ctrl.SetTimeBase(time_base, d_filter_tau);
+    ctrl.control_every = control_every;
+    ReplayStats stats = Replay(trace, ctrl, out_path ? &out : nullptr);
+    out.Close();
+
+    LOG_RESULT("Replayed " << stats.frames << " frames in " << stats.seconds << " s ("
+               << (stats.seconds > 0 ? stats.frames / stats.seconds : 0) << " frames/s)\n"
+               << "Steering difference to recording: mean " << stats.mean_steer_diff
+               << " max " << stats.max_steer_diff);
+    return 0;
+}
+
+/** Run the controller closed loop against the built-in vehicle model
+ * @param frames      Number of telemetry frames to simulate
+ * @param trace_path  Where to record the run, may be null
+ * @param time_base, d_filter_tau, control_every  Controller timing, see Controller
+ */
+int simulate(int frames, const char *trace_path, double sParams[], double tParams[],
+             double time_base, double d_filter_tau, int control_every)
+{
+    TraceWriter trace;
+    if (trace_path && !trace.Open(trace_path))
+    {
+        LOG_ERROR("Failed to open trace " << trace_path);
+        return -1;
+    }
+
+    Scenario scenario;
+    Vehicle car(scenario.track, scenario.vehicle, scenario.seed);
+    Controller ctrl;
+    ctrl.Init(sParams, tParams, throttleMean, throttleMax);
+    ctrl.pid.SetAntiWindup(antiWindup);
+    if (!gainSchedule.Empty())
+        ctrl.pid.schedule = &gainSchedule;
+    ctrl.SetTimeBase(time_base, d_filter_tau);
+    ctrl.control_every = control_every;
+
+    DriveMetrics metrics;
+    int off_track = 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        const Telemetry t = car.Observe();
+        double steer_value, throttle;
+        ctrl.Step(t.cte, t.speed, scenario.vehicle.dt, steer_value, throttle);
+        car.Step(steer_value, throttle);
+
+        metrics.Add(t.cte, t.speed, steer_value);
+        off_track += car.OffTrack();
+        LOG_DEBUG_EVERY_N(logSampleEvery, "CTE: " << t.cte << " Steering Value: " << steer_value
+                          << " Speed: " << t.speed);
+        if (trace.IsOpen())
+            trace.Append(TraceFrame{static_cast<int64_t>(i * scenario.vehicle.dt * 1e9), t.cte,
+                                    t.speed, t.steering_angle, steer_value, throttle});
+    }
+    trace.Close();
+
+    LOG_RESULT("Simulated " << frames << " frames, " << off_track << " off track: " << metrics.Summary());
+    return 0;
+}
+
+/** Tune the steering gains over the vehicle model
+ * @param method      "twiddle" or an Optimizer method, see MakeOptimizer
+ * @param threads     Worker threads, 0 uses all cores
+ * @param max_evals   Episode budget of the population methods
+ * @param curve_path  Where to write the convergence curve, may be null
+ * @param checkpoint_path  Where the twiddle checkpoints go, may be null
+ * @param resume      Continue from the checkpoint
+ * @param cache_path  Evaluation cache to consult and update, may be null
+ * @param time_base, d_filter_tau, control_every  Controller timing, see Controller
+ */
+int tune(const char *method, int threads, int max_evals, const char *curve_path,
+         const char *checkpoint_path, bool resume, const char *cache_path,
+         double time_base, double d_filter_tau, int control_every)
+{
+    Scenario scenario;
+    scenario.anti_windup = antiWindup;
+    scenario.time_base = time_base;
+    scenario.d_filter_tau = d_filter_tau;
+    scenario.control_every = control_every;
+    // A schedule would replace the very gains being tuned
+    if (!gainSchedule.Empty())
+        LOG_INFO("Ignoring --schedule while tuning the fixed gains");
+    ThreadPool pool(threads);
+    EvalCache cache;
+    if (!loadCache(cache, cache_path))
+        return -1;
+    EvalCache *use_cache = cache_path ? &cache : nullptr;
+
+    // Same starting point and stopping threshold as twiddle()
+    double p[3] = {1, 0, 3.31};
+    double dp[3] = {1, 1, 1};
+    TuneResult res;
+    if (std::strcmp(method, "twiddle") == 0)
+    {
+        ParallelTwiddle tuner(scenario, pool);
+        tuner.SetCache(use_cache);
+        tuner.SetEarlyStop(earlyStop, crashCte);
+        if (checkpoint_path)
+            tuner.SetCheckpoint(checkpoint_path);
+        TuneCheckpoint checkpoint;
+        if (resume && LoadCheckpoint(checkpoint_path, checkpoint) && checkpoint.kind == TunerKind::PARALLEL_TWIDDLE)
+        {
+            LOG_INFO("Resuming from " << checkpoint_path << " after " << checkpoint.sweeps << " sweeps, "
+                     << checkpoint.evaluations << " evaluations");
+            res = tuner.Resume(checkpoint, 0.01, 10000);
+        }
+        else
+        {
+            if (resume)
+                LOG_ERROR("No parallel twiddle checkpoint in " << checkpoint_path << ", starting over");
+            res = tuner.Run(p, dp, 0.01, 10000);
+        }
+    }
+    else
+    {
+        // Initial spread per gain, narrower than twiddle's dp on the integral
+        //  gain, where large steps mostly drive the car off the track
+        const std::vector<double> x0(p, p + 3);
+        const std::vector<double> step0 = {0.5, 0.1, 1.0};
+        std::unique_ptr<Optimizer> optimizer = MakeOptimizer(method, x0, step0, pool.Size(), scenario.seed);
+        if (!optimizer)
+        {
+            LOG_ERROR("Unknown tuning method " << method);
+            return -1;
+        }
+        if (checkpoint_path)
+            LOG_INFO("Checkpoints are only written by twiddle, ignoring " << checkpoint_path);
+        PopulationTuner tuner(scenario, pool);
+        tuner.SetCache(use_cache);
+        tuner.SetEarlyStop(crashCte);
+        res = tuner.Run(*optimizer, 1e-4, max_evals);
+    }
+
+    LOG_RESULT("best_p=[" << res.p[0] << ", " << res.p[1] << ", " << res.p[2] << "] best_err: " << res.best_err
+               << "\n" << method << ": " << res.sweeps << " sweeps, " << res.evaluations << " evaluations in "
+               << res.seconds << " s on " << pool.Size() << " threads (" << res.evaluations / res.seconds
+               << " evaluations/s, " << res.frames << " frames simulated)");
+    if (use_cache)
+    {
+        LOG_INFO("Evaluation cache: " << cache.Hits() << " hits, " << cache.Misses() << " misses, "
+                 << cache.Size() << " entries");
+        if (!cache.Save(cache_path))
+            LOG_ERROR("Failed to write evaluation cache " << cache_path);
+    }
+
+    if (curve_path)
+    {
+        std::ofstream curve(curve_path);
+        curve << "evaluations,seconds,best_err\n";
+        for (const ConvergencePoint &c : res.curve)
+            curve << c.evaluations << "," << c.seconds << "," << c.best_err << "\n";
+        if (!curve)
+        {
+            LOG_ERROR("Failed to write " << curve_path);
+            return -1;
+        }
+    }
+    return 0;
 }
 
-int twiddle()
+/** Twiddle the steering gains against the live simulator
+ * @param checkpoint_path  Where to save the state after every step, may be null
+ * @param resume           Continue from the checkpoint
+ * @param cache_path       Evaluation cache to consult and update, may be null
+ * @param settings         Fingerprint of the options the cached costs depend on
+ */
+int twiddle(const char *checkpoint_path, bool resume, const char *cache_path, uint64_t settings)
 {
     uWS::Hub h;
 
     PID pid;
+    pid.SetOutputLimits(-1, 1);
+    pid.SetAntiWindup(antiWindup);
 
     // Assuming the twiddle algo is like a finite state machine, then the
     //  following are the states of the FSM
@@ -293,26 +798,139 @@ int twiddle()
 
     // Init and run some iterations here. Compute the best_err
     double err = 0;
+    bool done = false;
+    bool pruned = false;
+    std::vector<EvalRecord> history;
+
+    // Everything above goes into the checkpoint. A run that was interrupted
+    //  half way is started over, since its frames are gone.
+    auto save = [&]() {
+        if (!checkpoint_path)
+            return;
+        TuneCheckpoint checkpoint;
+        checkpoint.kind = TunerKind::LIVE_TWIDDLE;
+        checkpoint.stage = state.stage;
+        checkpoint.curr_i = state.curr_i;
+        checkpoint.curr_iter = state.curr_iter;
+        checkpoint.evaluations = static_cast<int32_t>(history.size());
+        checkpoint.done = done;
+        checkpoint.pruned = pruned;
+        std::copy(state.p, state.p + 3, checkpoint.p);
+        std::copy(state.dp, state.dp + 3, checkpoint.dp);
+        std::copy(best_p, best_p + 3, checkpoint.best_p);
+        checkpoint.best_err = state.best_err;
+        checkpoint.err = err;
+        checkpoint.history = history;
+        if (!SaveCheckpoint(checkpoint_path, checkpoint))
+            LOG_ERROR("Failed to write checkpoint " << checkpoint_path);
+    };
+    // Finished runs are also memoized, so a p that comes around again (or
+    //  was scored by an earlier session) doesn't need another run
+    EvalCache cache;
+    if (!loadCache(cache, cache_path))
+        return -1;
+    Fingerprinter fp;
+    fp.Add("live");
+    fp.Add(iters);
+    fp.Add(&settings, sizeof(settings));
+    const uint64_t live = fp.Value();
+    auto record = [&](double run_err) {
+        history.push_back(EvalRecord{{state.p[0], state.p[1], state.p[2]}, run_err});
+        // A pruned run only bounds the cost, it must not be reused as exact
+        if (cache_path && !pruned)
+        {
+            cache.Insert(live, state.p, run_err);
+            if (!cache.Save(cache_path))
+                LOG_ERROR("Failed to write evaluation cache " << cache_path);
+        }
+    };
+    // Start a run for the current p: either answer it from the cache, or
+    //  reset the simulator and collect 2 * iters frames
+    auto startRun = [&](uWS::WebSocket<uWS::SERVER> ws) {
+        pid.Init(state.p[0], state.p[1], state.p[2]);
+        pruned = false;
+        double cost;
+        if (cache_path && cache.Lookup(live, state.p, cost))
+        {
+            LOG_INFO("Cached run, err: " << cost);
+            err = cost * iters;
+            state.curr_iter = 2 * iters;
+            return;
+        }
+        std::string msg = "42[\"reset\",{}]";
+        ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
+        state.curr_iter = 0;
+        err = 0;
+        LOG_INFO("Reset called");
+    };
+
+    TuneCheckpoint checkpoint;
+    if (resume && LoadCheckpoint(checkpoint_path, checkpoint) && checkpoint.kind == TunerKind::LIVE_TWIDDLE)
+    {
+        state.stage = static_cast<TwiddleGoto>(checkpoint.stage);
+        state.curr_i = checkpoint.curr_i;
+        state.curr_iter = checkpoint.curr_iter < 2 * iters ? 0 : checkpoint.curr_iter;
+        std::copy(checkpoint.p, checkpoint.p + 3, state.p);
+        std::copy(checkpoint.dp, checkpoint.dp + 3, state.dp);
+        std::copy(checkpoint.best_p, checkpoint.best_p + 3, best_p);
+        state.best_err = checkpoint.best_err;
+        err = checkpoint.curr_iter < 2 * iters ? 0 : checkpoint.err;
+        history = checkpoint.history;
+        done = checkpoint.done;
+        pruned = checkpoint.pruned;
+        LOG_INFO("Resuming twiddle from " << checkpoint_path << " after " << history.size() << " runs");
+    }
+    else if (resume)
+    {
+        LOG_ERROR("No twiddle checkpoint in " << checkpoint_path << ", starting over");
+    }
+    if (done)
+    {
+        LOG_RESULT("Twiddle already finished, best_p=[" << best_p[0] << ", " << best_p[1] << ", " << best_p[2]
+                   << "] best_err: " << state.best_err);
+        return 0;
+    }
+
     pid.Init(state.p[0], state.p[1], state.p[2]);
-    h.onMessage([&pid, &state, iters, &err, &best_p, threshold, &throttle](uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length, uWS::OpCode opCode) {
-        std::cout << "curr_iter: " << state.curr_iter;
-        std::cout << " p=[" << state.p[0] << ", " << state.p[1] << ", " << state.p[2] << "]";
-        std::cout << " best_p=[" << best_p[0] << ", " << best_p[1] << ", " << best_p[2] << "]";
-        std::cout << " dp=[" << state.dp[0] << ", " << state.dp[1] << ", " << state.dp[2] << "]";
-        std::cout << " best_err: " << state.best_err;
-        std::cout << " curr_err: " << err / abs(state.curr_iter - iters) << std::endl;
+    SteerMessage reply;
+    h.onMessage([&h, &pid, &state, iters, &err, &best_p, threshold, &throttle, &reply, &done, &pruned, &save, &record, &startRun](uWS::WebSocket<uWS::SERVER> ws, char *data, size_t length, uWS::OpCode opCode) {
+        LOG_DEBUG_EVERY_N(logSampleEvery, "curr_iter: " << state.curr_iter
+                  << " p=[" << state.p[0] << ", " << state.p[1] << ", " << state.p[2] << "]"
+                  << " best_p=[" << best_p[0] << ", " << best_p[1] << ", " << best_p[2] << "]"
+                  << " dp=[" << state.dp[0] << ", " << state.dp[1] << ", " << state.dp[2] << "]"
+                  << " best_err: " << state.best_err
+                  << " curr_err: " << err / abs(state.curr_iter - iters));
 
         if (state.curr_iter < 2 * iters)
         {
             // The run() function from the python code
             // This will only run when curr_iter < 2*iters. All other times the
             //  twiddle statess are hanled
-            double cte = handleMessage(ws, data, length, opCode, pid, throttle);
+            double cte = handleMessage(ws, data, length, opCode, pid, throttle, reply);
             if (state.curr_iter > iters)
             {
                 err += abs(cte); //pow(cte, 2);
             }
             state.curr_iter++;
+
+            // Give up on a run that can no longer beat best_err or crashed.
+            //  The first run has nothing to compare against.
+            if ((earlyStop || crashCte > 0) && state.stage != TwiddleGoto::INIT)
+            {
+                StopPolicy policy;
+                policy.bound = earlyStop ? state.best_err * iters : HUGE_VAL;
+                policy.crash_cte = crashCte;
+                const StopReason reason = CheckStop(policy, cte, err);
+                if (reason != StopReason::NONE)
+                {
+                    LOG_INFO("Run stopped after " << state.curr_iter << " frames: "
+                             << (reason == StopReason::CRASH ? "crashed" : "can't beat best_err"));
+                    if (reason == StopReason::CRASH)
+                        err = HUGE_VAL;
+                    state.curr_iter = 2 * iters;
+                    pruned = true;
+                }
+            }
         }
         else
         {
@@ -322,13 +940,14 @@ int twiddle()
             // The very first run, before the iterations start
             case TwiddleGoto::INIT:
                 state.best_err = err / iters;
+                record(state.best_err);
                 err = 0;
                 state.stage = TwiddleGoto::CHECKSUM;
                 break;
             // The while loop condition
             case TwiddleGoto::CHECKSUM:
             {
-                std::cout << "Case:CHECKSUM" << std::endl;
+                LOG_INFO("Case:CHECKSUM");
                 double sum_dp = state.dp[0] + state.dp[1] + state.dp[2];
                 if (sum_dp > threshold)
                 {
@@ -337,7 +956,13 @@ int twiddle()
                 }
                 else
                 {
-                    exit(0);
+                    // Done: keep the result and stop serving, twiddle() returns
+                    done = true;
+                    save();
+                    LOG_RESULT("best_p=[" << best_p[0] << ", " << best_p[1] << ", " << best_p[2]
+                               << "] best_err: " << state.best_err);
+                    h.getDefaultGroup<uWS::SERVER>().close();
+                    return;
                 }
             }
             // The for loop condition
@@ -345,23 +970,17 @@ int twiddle()
             // curr_iter is set to zero so we can get the data from the simulator
             case TwiddleGoto::LOOPCOVER:
             {
-                std::cout << "Case:LOOPCOVER" << std::endl;
+                LOG_INFO("Case:LOOPCOVER");
                 state.p[state.curr_i] += state.dp[state.curr_i];
-                pid.Init(state.p[0], state.p[1], state.p[2]);
-                state.curr_iter = 0;
                 state.stage = TwiddleGoto::OUTERIF;
-                // Reset
-                std::string msg = "42[\"reset\",{}]";
-                ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
-                state.curr_iter = 0;
-                err = 0;
-                std::cout << "Reset called" << std::endl;
+                startRun(ws);
                 break;
             }
             // The outer if
             case TwiddleGoto::OUTERIF:
-                std::cout << "Case:OUTERIF" << std::endl;
+                LOG_INFO("Case:OUTERIF");
                 err /= iters;
+                record(err);
                 if (err < state.best_err)
                 {
                     state.best_err = err;
@@ -383,20 +1002,14 @@ int twiddle()
                 else
                 {
                     state.p[state.curr_i] -= 2 * state.dp[state.curr_i];
-                    pid.Init(state.p[0], state.p[1], state.p[2]);
-                    state.curr_iter = 0;
                     state.stage = TwiddleGoto::OUTERELSE;
-                    // Reset
-                    std::string msg = "42[\"reset\",{}]";
-                    ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
-                    state.curr_iter = 0;
-                    err = 0;
-                    std::cout << "Reset called" << std::endl;
+                    startRun(ws);
                     break;
                 }
             case TwiddleGoto::OUTERELSE:
-                std::cout << "Case:OUTERELSE" << std::endl;
+                LOG_INFO("Case:OUTERELSE");
                 err /= iters;
+                record(err);
                 if (err < state.best_err)
                 {
                     state.best_err = err;
@@ -414,13 +1027,12 @@ int twiddle()
                 state.stage = TwiddleGoto::LOOPCOVER;
                 break;
             }
+            save();
+
             // When handling twiddle state, send null values
-            std::cout << "Next Iter" << std::endl;
-            json msgJson;
-            msgJson["steering_angle"] = 0;
-            msgJson["throttle"] = 0;
-            auto msg = "42[\"steer\"," + msgJson.dump() + "]";
-            ws.send(msg.data(), msg.length(), uWS::OpCode::TEXT);
+            LOG_DEBUG("Next Iter");
+            static const char msg[] = "42[\"steer\",{\"steering_angle\":0,\"throttle\":0}]";
+            ws.send(msg, sizeof(msg) - 1, uWS::OpCode::TEXT);
         }
     });
 
@@ -440,24 +1052,32 @@ int twiddle()
     });
 
     h.onConnection([&h](uWS::WebSocket<uWS::SERVER> ws, uWS::HttpRequest req) {
-        std::cout << "Connected!!!" << std::endl;
+        LOG_INFO("Connected!!!");
     });
 
-    h.onDisconnection([&h](uWS::WebSocket<uWS::SERVER> ws, int code, char *message, size_t length) {
+    h.onDisconnection([&pid, &state, iters, &err](uWS::WebSocket<uWS::SERVER> ws, int code, char *message, size_t length) {
         ws.close();
-        std::cout << "Disconnected" << std::endl;
+        LOG_INFO("Disconnected");
+        // Start the interrupted run over once the simulator reconnects
+        if (state.curr_iter < 2 * iters)
+        {
+            state.curr_iter = 0;
+            err = 0;
+            pid.Init(state.p[0], state.p[1], state.p[2]);
+        }
     });
 
     int port = 4567;
     if (h.listen(port))
     {
-        std::cout << "Listening to port " << port << std::endl;
+        LOG_INFO("Listening to port " << port);
     }
     else
     {
-        std::cerr << "Failed to listen to port" << std::endl;
+        LOG_ERROR("Failed to listen to port");
         return -1;
     }
 
     h.run();
+    return 0;
 }